@@ -0,0 +1,76 @@
+// -----------------------------------------------------------
+//  File: arena.cc
+//  Author: Gregory Rehbein
+//
+//  Copyright (C) 2012 Gregory Rehbein <gmrehbein@gmail.com>
+// -----------------------------------------------------------
+
+// Self
+#include "arena.h"
+
+// C
+#include <cassert>
+
+// C++
+#include <new>
+
+#include "global.h"
+
+namespace
+{
+const size_t kBlockBytes = 1 << 18;
+}  // end anon namespace
+
+const size_t Arena::kAlignment;
+
+Arena::Arena(size_t objectSize)
+  : m_objectSize((objectSize + kAlignment - 1)/kAlignment*kAlignment),
+    m_block(0), m_next(NULL), m_end(NULL), m_free(NULL)
+{
+  assert(objectSize >= sizeof(void*));
+  assert(objectSize > 0);
+  size_t objectsPerBlock = kBlockBytes/m_objectSize;
+  m_blockSize = (objectsPerBlock ? objectsPerBlock : 1)*m_objectSize;
+}
+
+Arena::~Arena()
+{
+  for (size_t i = 0; i < m_blocks.size(); ++i)
+    Global::AlignedAllocator::free(m_blocks[i]);
+}
+
+void Arena::release()
+{
+  m_block = 0;
+  m_next = m_end = NULL;
+  m_free = NULL;
+}
+
+//--------------------------------
+// Moves on to the next block,
+// allocating it only the first time
+// a run reaches it
+//--------------------------------
+void Arena::grow()
+{
+  if (m_block == m_blocks.size()) {
+    char* block = Global::AlignedAllocator::malloc(m_blockSize);
+    if (!block)
+      throw std::bad_alloc();
+    m_blocks.push_back(block);
+  }
+  m_next = m_blocks[m_block++];
+  m_end = m_next + m_blockSize;
+}
+
+size_t Arena::allocatedBytes() const
+{
+  if (m_block == 0)
+    return 0;
+  return (m_block - 1)*m_blockSize + (m_blockSize - (m_end - m_next));
+}
+
+size_t Arena::reservedBytes() const
+{
+  return m_blocks.size()*m_blockSize;
+}
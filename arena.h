@@ -0,0 +1,91 @@
+// -----------------------------------------------------------
+//  File: arena.h
+//  Author: Gregory Rehbein
+//
+//  Arena class declaration. A bump allocator of fixed-size,
+//  cache-line aligned objects, used for the rectangles of an
+//  optimizer run. In debug builds a Rectangle holds its span
+//  inline, so one allocation carries the rectangle and its
+//  span storage together. Objects are laid out contiguously in large
+//  blocks; release() rewinds to the first block in O(1)
+//  without freeing anything, so once an arena has grown to
+//  the largest run it has seen, later runs allocate nothing
+//  from the heap. Objects are never destroyed and must be
+//  trivially destructible, but the storage of one that is no
+//  longer needed can be handed back with free(): freed slots
+//  are kept on an intrusive list and reused first, so memory
+//  follows the objects alive rather than all those made.
+//
+//  Copyright (C) 2012 Gregory Rehbein <gmrehbein@gmail.com>
+// -----------------------------------------------------------
+
+#ifndef ARENA_H
+#define ARENA_H
+
+#include <cstddef>
+#include <vector>
+#include <boost/utility.hpp>
+
+class Arena : boost::noncopyable
+{
+public:
+  explicit Arena(size_t objectSize);
+  ~Arena();
+
+  //--------------------------------
+  // Storage for one object, aligned
+  // to a cache line
+  //--------------------------------
+  inline void* malloc() {
+    if (m_free) {
+      void* object = m_free;
+      m_free = *static_cast<void**>(object);
+      return object;
+    }
+    if (m_next == m_end)
+      grow();
+    void* object = m_next;
+    m_next += m_objectSize;
+    return object;
+  }
+
+  //--------------------------------
+  // Gives the storage of an object back
+  // for reuse by a later malloc(). It
+  // may come from another arena of the
+  // same object size, provided both are
+  // released together.
+  //--------------------------------
+  inline void free(void* object) {
+    *static_cast<void**>(object) = m_free;
+    m_free = object;
+  }
+
+  //--------------------------------
+  // Releases every object at once,
+  // keeping the blocks for reuse
+  //--------------------------------
+  void release();
+
+  //--------------------------------
+  // Bytes handed out since the last
+  // release() and bytes held in blocks
+  //--------------------------------
+  size_t allocatedBytes() const;
+  size_t reservedBytes() const;
+
+  static const size_t kAlignment = 64;
+
+private:
+  void grow();
+
+  size_t m_objectSize;  // rounded up to kAlignment
+  size_t m_blockSize;
+  std::vector<char*> m_blocks;
+  size_t m_block;  // index of the current block + 1, 0 before the first
+  char* m_next;
+  char* m_end;
+  void* m_free;  // list of freed objects, linked through their first word
+};
+
+#endif // ARENA_H
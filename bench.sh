@@ -0,0 +1,56 @@
+#!/bin/sh
+# -----------------------------------------------------------
+#  File: bench.sh
+#  Author: Gregory Rehbein
+#
+#  Benchmark suite run by 'make bench'. Generates the seeded
+#  benchmark fields, optimizes them with --stats and reports
+#  the cost and per-phase wall time of each field, so that a
+#  speed-up can be checked against a loss of quality.
+#
+#  Environment: SEED (=2012), COUNT fields per layout (=2),
+#  FLAGS passed on to strawberryfields.
+#
+#  Copyright (C) 2012 Gregory Rehbein <gmrehbein@gmail.com>
+# -----------------------------------------------------------
+
+SEED=${SEED:-2012}
+COUNT=${COUNT:-2}
+
+./fieldgen --seed "$SEED" --count "$COUNT" > bench_fields.txt || exit 1
+rm -f bench_covering.txt
+./strawberryfields -f bench_fields.txt -o bench_covering.txt \
+  --stats bench_stats.jsonl $FLAGS > /dev/null || exit 1
+
+awk -v count="$COUNT" -v seed="$SEED" '
+function value(key,    s) {
+  if (!match($0, "\"" key "\":[0-9.]+"))
+    return 0
+  s = substr($0, RSTART, RLENGTH)
+  sub(/.*:/, "", s)
+  return s
+}
+function wall(phase,    s) {
+  if (!match($0, "\"" phase "\":{\"wall\":[0-9.]+"))
+    return 0
+  s = substr($0, RSTART, RLENGTH)
+  sub(/.*:/, "", s)
+  return s * 1000
+}
+BEGIN {
+  split("sparse dense clustered checkerboard worst", layouts, " ")
+  printf("seed %d, %d fields per layout; wall times in ms\n", seed, count)
+  printf("%5s %-13s %12s %4s %6s %9s %9s %9s %12s\n", "field", "layout",
+         "strawberries", "max", "cost", "total", "generate", "greedy", "localSearch")
+}
+{
+  field = value("field")
+  printf("%5d %-13s %12d %4d %6d %9.3f %9.3f %9.3f %12.3f\n", field,
+         layouts[int(field / count) + 1], value("strawberries"), value("maxRectangles"),
+         value("cost"), wall("total"), wall("generate"), wall("greedy"), wall("localSearch"))
+  cost += value("cost")
+  total += wall("total")
+}
+END {
+  printf("total cost %d in %.3f ms\n", cost, total)
+}' bench_stats.jsonl
@@ -0,0 +1,146 @@
+// -----------------------------------------------------------
+//  File: binary.cc
+//  Author: Gregory Rehbein
+//
+//  Copyright (C) 2012 Gregory Rehbein <gmrehbein@gmail.com>
+// -----------------------------------------------------------
+
+// Self
+#include "binary.h"
+
+// C
+#include <cassert>
+#include <cstdio>
+#include <stdint.h>
+
+// C++
+#include <fstream>
+#include <iterator>
+#include <vector>
+
+// Boost
+#include <boost/foreach.hpp>
+
+#include "covering.h"
+#include "sink.h"
+
+using std::string;
+
+#define foreach BOOST_FOREACH
+
+namespace
+{
+const char kCoveringRecord = 'C';
+const char kTotalCostRecord = 'T';
+
+//--------------------------------------------
+// Appends the low bytes of value to *block,
+// least significant first
+//--------------------------------------------
+void put(string* block, uint64_t value, int bytes)
+{
+  for (int i = 0; i < bytes; ++i, value >>= 8)
+    block->push_back(char(value & 0xff));
+}
+
+//--------------------------------------------
+// Reads an integer of the given width at
+// *position, advancing it. Returns false if
+// the input ends first.
+//--------------------------------------------
+bool get(const char** position, const char* end, int bytes, uint64_t* value)
+{
+  if (end - *position < bytes)
+    return false;
+  *value = 0;
+  for (int i = bytes - 1; i >= 0; --i)
+    *value = *value << 8 | static_cast<unsigned char>((*position)[i]);
+  *position += bytes;
+  return true;
+}
+
+//--------------------------------------------
+// Renders the covering record at *position,
+// which follows its tag, to *block
+//--------------------------------------------
+bool convertCovering(const char** position, const char* end, string* block)
+{
+  uint64_t field, rows, columns, cardinality, cost;
+  if (!get(position, end, 4, &field) || !get(position, end, 2, &rows)
+      || !get(position, end, 2, &columns) || !get(position, end, 4, &cardinality)
+      || !get(position, end, 8, &cost))
+    return false;
+  Covering covering;
+  for (uint64_t k = 0; k < cardinality; ++k) {
+    uint64_t corner[4];
+    for (int i = 0; i < 4; ++i) {
+      if (!get(position, end, 2, &corner[i]))
+        return false;
+    }
+    if (corner[0] > corner[2] || corner[1] > corner[3]
+        || corner[2] >= rows || corner[3] >= columns)
+      return false;
+    Box box = { int(corner[0]), int(corner[1]), int(corner[2]), int(corner[3]) };
+    covering.add(box);
+  }
+  if (uint64_t(covering.cost()) != cost)
+    return false;
+  covering.render(block, rows, columns);
+  return true;
+}
+}  // end anon namespace
+
+void encodeCovering(string* block, size_t fieldId,
+                    size_t numRows, size_t numColumns, const Covering& covering)
+{
+  assert(numRows <= 0xffff && numColumns <= 0xffff);
+  block->push_back(kCoveringRecord);
+  put(block, fieldId, 4);
+  put(block, numRows, 2);
+  put(block, numColumns, 2);
+  put(block, covering.size(), 4);
+  put(block, covering.cost(), 8);
+  foreach(const Box& box, covering.boxes()) {
+    put(block, box.topLeftRow, 2);
+    put(block, box.topLeftColumn, 2);
+    put(block, box.bottomRightRow, 2);
+    put(block, box.bottomRightColumn, 2);
+  }
+}
+
+void encodeTotalCost(string* block, long long totalCost)
+{
+  block->push_back(kTotalCostRecord);
+  put(block, totalCost, 8);
+}
+
+bool convertToText(const string& path, OutputSink& output)
+{
+  std::ifstream file(path.c_str(), std::ios::binary);
+  const std::vector<char> input((std::istreambuf_iterator<char>(file)),
+                                std::istreambuf_iterator<char>());
+  const char* position = input.empty() ? NULL : &input[0];
+  const char* end = position + input.size();
+
+  string block;
+  while (position < end) {
+    const char tag = *position++;
+    if (tag == kCoveringRecord) {
+      if (!convertCovering(&position, end, &block))
+        return false;
+    } else if (tag == kTotalCostRecord) {
+      uint64_t cost;
+      if (!get(&position, end, 8, &cost))
+        return false;
+      char line[64];
+      int length = snprintf(line, sizeof(line), "Total Cost: %lld\n", (long long)cost);
+      block.append(line, length);
+    } else {
+      return false;
+    }
+    output.write(&block);
+  }
+  return true;
+}
+
+#undef foreach
@@ -0,0 +1,63 @@
+// -----------------------------------------------------------
+//  File: binary.h
+//  Author: Gregory Rehbein
+//
+//  The compact binary output format (--binary). Instead of the
+//  painted grid, each covering is one record holding little
+//  more than its corners:
+//
+//    'C'          u8   covering record
+//    field        u32  index of the field in the input
+//    rows         u16  dimensions of the field
+//    columns      u16
+//    cardinality  u32  number of rectangles
+//    cost         u64
+//    corners      4 x u16 per rectangle, in label order:
+//                 top row, left column, bottom row,
+//                 right column
+//
+//  and the total cost of a run is a record of its own:
+//
+//    'T'          u8   total cost record
+//    cost         u64
+//
+//  Integers are little-endian. The records of a run follow one
+//  another as the text blocks of the output file do, and
+//  runs appended to one file stay separated by their totals,
+//  so convertToText() gives back the text output exactly.
+//
+//  Copyright (C) 2012 Gregory Rehbein <gmrehbein@gmail.com>
+// -----------------------------------------------------------
+
+#ifndef BINARY_H
+#define BINARY_H
+
+#include <cstddef>
+#include <string>
+
+class Covering;
+class OutputSink;
+
+//--------------------------------------------
+// Appends the record of the covering of
+// field fieldId, of numRows X numColumns,
+// to *block
+//--------------------------------------------
+void encodeCovering(std::string* block, size_t fieldId,
+                    size_t numRows, size_t numColumns, const Covering& covering);
+
+//--------------------------------------------
+// Appends the total cost record to *block
+//--------------------------------------------
+void encodeTotalCost(std::string* block, long long totalCost);
+
+//--------------------------------------------
+// Writes the records of the binary file at
+// path to output in the text format. Returns
+// false, having written the records before
+// it, at the first record that is truncated
+// or malformed.
+//--------------------------------------------
+bool convertToText(const std::string& path, OutputSink& output);
+
+#endif // BINARY_H
@@ -0,0 +1,323 @@
+// -----------------------------------------------------------
+//  File: branchandbound.cc
+//  Author: Gregory Rehbein
+//
+//  Copyright (C) 2012 Gregory Rehbein <gmrehbein@gmail.com>
+// -----------------------------------------------------------
+
+// Self
+#include "branchandbound.h"
+
+// C
+#include <cassert>
+#include <climits>
+#include <cmath>
+
+// C++
+#include <algorithm>
+#include <limits>
+
+// Boost
+#include <boost/foreach.hpp>
+
+#include "field.h"
+#include "timer.h"
+
+using std::pair;
+using std::vector;
+using std::min;
+using std::stable_sort;
+
+#define foreach BOOST_FOREACH
+
+namespace
+{
+// slack for comparing sums of shares with integer costs
+const double kEpsilon = 1e-9;
+
+//------------------------------------------------
+// Tight rectangle of the field and its cost per
+// strawberry
+//------------------------------------------------
+struct Ratio {
+  double costPerStrawberry;
+  Box box;
+  inline bool operator<(const Ratio& other) const {
+    return costPerStrawberry < other.costPerStrawberry;
+  }
+};
+
+//------------------------------------------------
+// Finds the first unpainted strawberry at or after
+// column c of a row, with path compression
+//------------------------------------------------
+int findUnpainted(vector<int>& next, int c)
+{
+  int root = c;
+  while (next[root] != root)
+    root = next[root];
+  while (next[c] != root) {
+    int up = next[c];
+    next[c] = root;
+    c = up;
+  }
+  return root;
+}
+}  // end anon namespace
+
+//------------------------------------------------------
+// Child of a search node: the tight rectangle that
+// covers the node's first uncovered strawberry, and the
+// bound on the coverings that extend it
+//------------------------------------------------------
+struct BranchAndBound::Branch {
+  Box box;
+  size_t weight;
+  double share;
+  double bound;
+  inline bool operator<(const Branch& other) const {
+    return bound < other.bound;
+  }
+};
+
+BranchAndBound::BranchAndBound()
+  : m_field(NULL), m_maxRectangles(0), m_timeBudget(0), m_deadline(0),
+    m_aborted(false), m_nodes(0), m_lowerBound(0), m_cost(0), m_remaining(0),
+    m_remainingShare(0), m_incumbentCost(0), m_openBound(0)
+{
+}
+
+void BranchAndBound::setMaxRectangles(int m)
+{
+  m_maxRectangles = m;
+}
+
+void BranchAndBound::setTimeBudget(double seconds)
+{
+  m_timeBudget = seconds;
+}
+
+bool BranchAndBound::improve(const Field& field, Covering* covering)
+{
+  m_field = &field;
+  const size_t M = field.numRows();
+  const size_t N = field.numColumns();
+
+  m_strawberries.assign(field.strawberries().begin(), field.strawberries().end());
+  computeShares();
+
+  m_chosen.clear();
+  m_cost = 0;
+  m_remaining = m_strawberries.size();
+  m_remainingShare = m_share[M][N];
+  m_occupied.assign(M, vector<char>(N, 0));
+  m_blocked.assign(M, vector<int>(N + 1, 0));
+
+  // a covering over the cardinality constraint is no incumbent
+  m_incumbent = *covering;
+  m_incumbentCost = m_incumbent.size() <= size_t(m_maxRectangles)
+                    ? m_incumbent.cost() : LLONG_MAX;
+  m_openBound = std::numeric_limits<double>::infinity();
+  m_nodes = 0;
+  m_aborted = false;
+  m_deadline = m_timeBudget > 0 ? wallTime() + m_timeBudget : 0;
+
+  if (m_remaining)
+    search(0);
+
+  // a bound on a sum of integer costs rounds up
+  double bound = m_openBound;
+  if (m_incumbentCost < bound)
+    bound = m_incumbentCost;
+  m_lowerBound = bound == LLONG_MAX ? LLONG_MAX : (long long)ceil(bound - kEpsilon);
+
+  if (m_incumbentCost != LLONG_MAX) {
+    *covering = m_incumbent;
+  }
+  m_field = NULL;
+  return m_lowerBound >= m_incumbentCost;
+}
+
+//--------------------------------------------------------
+// Each rectangle of a covering spreads its cost evenly over
+// its strawberries, so the cost of a covering is the sum of
+// these per-strawberry costs. No strawberry can pay less
+// than its share, the least cost per strawberry among the
+// tight rectangles containing it, so the cost of a partial
+// covering plus the shares of the strawberries it leaves
+// bounds the cost of every covering that extends it.
+//
+// Shares are painted in ascending order of cost per
+// strawberry, each strawberry taking the first rectangle
+// that reaches it; painted strawberries are skipped with a
+// union-find over the columns of each row.
+//--------------------------------------------------------
+void BranchAndBound::computeShares()
+{
+  const int M = m_field->numRows();
+  const int N = m_field->numColumns();
+
+  vector<Ratio> ratios;
+  for (int top = 0; top < M; ++top) {
+    for (int bottom = top; bottom < M; ++bottom) {
+      for (int left = 0; left < N; ++left) {
+        for (int right = left; right < N; ++right) {
+          if (!m_field->isTight(top, left, bottom, right))
+            continue;
+          Ratio ratio = { 0, { top, left, bottom, right } };
+          ratio.costPerStrawberry = double(ratio.box.cost())
+                                    / m_field->weightOfRectangle(top, left, bottom, right);
+          ratios.push_back(ratio);
+        }
+      }
+    }
+  }
+  stable_sort(ratios.begin(), ratios.end());
+
+  // next[row][c] leads to the first unpainted strawberry at or after c
+  vector<vector<int> > next(M, vector<int>(N + 1));
+  for (int row = 0; row < M; ++row) {
+    next[row][N] = N;
+    for (int col = N - 1; col >= 0; --col)
+      next[row][col] = m_field->at(row, col) ? col : next[row][col + 1];
+  }
+
+  vector<vector<double> > share(M, vector<double>(N, 0));
+  size_t unpainted = m_strawberries.size();
+  for (size_t k = 0; k < ratios.size() && unpainted; ++k) {
+    const Box& b = ratios[k].box;
+    for (int row = b.topLeftRow; row <= b.bottomRightRow; ++row) {
+      int col = findUnpainted(next[row], b.topLeftColumn);
+      while (col <= b.bottomRightColumn) {
+        share[row][col] = ratios[k].costPerStrawberry;
+        --unpainted;
+        next[row][col] = col + 1;
+        col = findUnpainted(next[row], col + 1);
+      }
+    }
+  }
+  assert(!unpainted);
+
+  m_share.assign(M + 1, vector<double>(N + 1, 0));
+  for (int i = 0; i < M; ++i)
+    for (int j = 0; j < N; ++j)
+      m_share[i + 1][j + 1] = share[i][j] + m_share[i][j + 1]
+                              + m_share[i + 1][j] - m_share[i][j];
+}
+
+double BranchAndBound::shareOf(const Box& b) const
+{
+  return m_share[b.bottomRightRow + 1][b.bottomRightColumn + 1]
+         - m_share[b.topLeftRow][b.bottomRightColumn + 1]
+         - m_share[b.bottomRightRow + 1][b.topLeftColumn]
+         + m_share[b.topLeftRow][b.topLeftColumn];
+}
+
+bool BranchAndBound::isBlocked(int row, int left, int right) const
+{
+  return m_blocked[row][right + 1] - m_blocked[row][left] > 0;
+}
+
+//--------------------------------------
+// Marks (value 1) or clears (value 0)
+// the cells of box in the partial covering
+//--------------------------------------
+void BranchAndBound::block(const Box& b, char value)
+{
+  const int N = m_field->numColumns();
+  for (int row = b.topLeftRow; row <= b.bottomRightRow; ++row) {
+    vector<char>& occupied = m_occupied[row];
+    std::fill(occupied.begin() + b.topLeftColumn,
+              occupied.begin() + b.bottomRightColumn + 1, value);
+    vector<int>& blocked = m_blocked[row];
+    for (int col = b.topLeftColumn; col < N; ++col)
+      blocked[col + 1] = blocked[col] + occupied[col];
+  }
+}
+
+//--------------------------------------------------------
+// The strawberries before the first uncovered one s are
+// covered, so a tight rectangle containing s that misses
+// the partial covering has s on its top edge: a strawberry
+// on any higher row would already be covered. Rectangles
+// are grown left, right and down from s, and each direction
+// stops at the first blocked cell.
+//--------------------------------------------------------
+void BranchAndBound::branch(size_t first, vector<Branch>* branches) const
+{
+  const int M = m_field->numRows();
+  const int N = m_field->numColumns();
+  const int top = m_strawberries[first].first;
+  const int column = m_strawberries[first].second;
+  const size_t depth = m_chosen.size() + 1;
+
+  for (int left = column; left >= 0 && !m_occupied[top][left]; --left) {
+    for (int right = column; right < N && !m_occupied[top][right]; ++right) {
+      for (int bottom = top; bottom < M && !isBlocked(bottom, left, right); ++bottom) {
+        if (!m_field->isTight(top, left, bottom, right))
+          continue;
+        Branch b = { { top, left, bottom, right }, 0, 0, 0 };
+        b.weight = m_field->weightOfRectangle(top, left, bottom, right);
+        // the last rectangle allowed must finish the covering
+        if (b.weight < m_remaining && depth >= size_t(m_maxRectangles))
+          continue;
+        b.share = shareOf(b.box);
+        b.bound = m_cost + b.box.cost() + (m_remainingShare - b.share);
+        branches->push_back(b);
+      }
+    }
+  }
+  stable_sort(branches->begin(), branches->end());
+}
+
+void BranchAndBound::search(size_t first)
+{
+  while (first < m_strawberries.size()
+         && m_occupied[m_strawberries[first].first][m_strawberries[first].second])
+    ++first;
+
+  if (first == m_strawberries.size()) {
+    if (m_cost < m_incumbentCost) {
+      m_incumbentCost = m_cost;
+      m_incumbent = Covering();
+      foreach(const Box& box, m_chosen) m_incumbent.add(box);
+      m_incumbent.order(*m_field);
+    }
+    return;
+  }
+
+  if ((++m_nodes & 1023) == 0 && m_deadline > 0 && wallTime() > m_deadline)
+    m_aborted = true;
+  if (m_aborted) {
+    m_openBound = min(m_openBound, m_cost + m_remainingShare);
+    return;
+  }
+
+  vector<Branch> branches;
+  branch(first, &branches);
+  foreach(const Branch& b, branches) {
+    // only a strictly cheaper covering improves the incumbent
+    if (b.bound > m_incumbentCost - 1 + kEpsilon)
+      break;
+    if (m_aborted) {
+      m_openBound = min(m_openBound, b.bound);
+      break;
+    }
+    const double remainingShare = m_remainingShare;
+    block(b.box, 1);
+    m_chosen.push_back(b.box);
+    m_cost += b.box.cost();
+    m_remaining -= b.weight;
+    m_remainingShare -= b.share;
+
+    search(first + 1);
+
+    m_remainingShare = remainingShare;
+    m_remaining += b.weight;
+    m_cost -= b.box.cost();
+    m_chosen.pop_back();
+    block(b.box, 0);
+  }
+}
+
+#undef foreach
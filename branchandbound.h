@@ -0,0 +1,119 @@
+// -----------------------------------------------------------
+//  File: branchandbound.h
+//  Author: Gregory Rehbein
+//
+//  BranchAndBound class declaration. An exact solver for the
+//  covering problem that improves on a heuristic covering and
+//  proves how far it is from optimal.
+//
+//  Every optimal covering may be taken to consist of tight
+//  rectangles (each edge of which holds a strawberry), since
+//  shrinking a rectangle to the hull of its strawberries keeps
+//  the covering disjoint and lowers its cost. The search
+//  partitions the strawberries into tight rectangles: each node
+//  branches on the rectangles that cover the first uncovered
+//  strawberry in row-major order. The warm start is the
+//  incumbent, and nodes are pruned with the bound described in
+//  branchandbound.cc.
+//
+//  Copyright (C) 2012 Gregory Rehbein <gmrehbein@gmail.com>
+// -----------------------------------------------------------
+
+#ifndef BRANCHANDBOUND_H
+#define BRANCHANDBOUND_H
+
+#include <vector>
+#include <utility>
+#include <boost/utility.hpp>
+#include "covering.h"
+
+class Field;
+
+class BranchAndBound : boost::noncopyable
+{
+public:
+  BranchAndBound();
+
+  //---------------------------------
+  // Sets the cardinality constraint
+  // on the maximum number of Rectangles
+  //---------------------------------
+  void setMaxRectangles(int maxRectangles);
+
+  //---------------------------------
+  // Wall-clock seconds a search may
+  // take. 0 searches to completion.
+  //---------------------------------
+  void setTimeBudget(double seconds);
+
+  //---------------------------------
+  // Searches for a covering of the
+  // field cheaper than *covering and
+  // stores the best one found there.
+  // Returns true if it is proven optimal.
+  //---------------------------------
+  bool improve(const Field& field, Covering* covering);
+
+  //---------------------------------
+  // Lower bound on the cost of any
+  // covering proven by the last search,
+  // and the number of nodes it visited
+  //---------------------------------
+  inline long long lowerBound() const {
+    return m_lowerBound;
+  }
+  inline size_t nodes() const {
+    return m_nodes;
+  }
+
+private:
+  struct Branch;
+
+  void computeShares();
+  void search(size_t first);
+  void branch(size_t first, std::vector<Branch>* branches) const;
+  void block(const Box& box, char value);
+  bool isBlocked(int row, int leftColumn, int rightColumn) const;
+  double shareOf(const Box& box) const;
+
+  const Field* m_field;
+  int m_maxRectangles;
+  double m_timeBudget;
+  double m_deadline;
+  bool m_aborted;
+  size_t m_nodes;
+  long long m_lowerBound;
+
+  //-----------------------------------
+  // Strawberries in row-major order, and
+  // the summed-area table of their shares:
+  // the least cost per strawberry of a
+  // tight rectangle containing each one
+  //-----------------------------------
+  std::vector<std::pair<int, int> > m_strawberries;
+  std::vector<std::vector<double> > m_share;
+
+  //-----------------------------------
+  // Partial covering of the current node,
+  // its cost, the number and total share
+  // of the strawberries it leaves, and
+  // per-row prefix counts of its cells
+  //-----------------------------------
+  std::vector<Box> m_chosen;
+  long long m_cost;
+  size_t m_remaining;
+  double m_remainingShare;
+  std::vector<std::vector<char> > m_occupied;
+  std::vector<std::vector<int> > m_blocked;
+
+  //-----------------------------------
+  // Best covering found so far, and the
+  // least bound among the nodes left
+  // unexplored when the budget ran out
+  //-----------------------------------
+  Covering m_incumbent;
+  long long m_incumbentCost;
+  double m_openBound;
+};
+
+#endif // BRANCHANDBOUND_H
@@ -0,0 +1,405 @@
+// -----------------------------------------------------------
+//  File: cache.cc
+//  Author: Gregory Rehbein
+//
+//  Copyright (C) 2012 Gregory Rehbein <gmrehbein@gmail.com>
+// -----------------------------------------------------------
+
+// Self
+#include "cache.h"
+
+// C
+#include <cassert>
+#include <cstdlib>
+#include <cstring>
+#include <stdint.h>
+
+// C++
+#include <algorithm>
+#include <utility>
+
+// Boost
+#include <boost/foreach.hpp>
+#include <boost/thread/locks.hpp>
+
+#include "field.h"
+#include "symmetry.h"
+
+using std::string;
+using std::vector;
+using std::swap;
+
+#define foreach BOOST_FOREACH
+
+namespace
+{
+typedef std::pair<int, int> Cell;
+
+//--------------------------------------------
+// Appends the bytes of value to *key
+//--------------------------------------------
+template <class T>
+void appendBytes(string* key, T value)
+{
+  key->append(reinterpret_cast<const char*>(&value), sizeof(value));
+}
+
+const char kHex[] = "0123456789abcdef";
+
+void appendHex(string* line, const string& bytes)
+{
+  for (size_t i = 0; i < bytes.size(); ++i) {
+    unsigned char c = bytes[i];
+    line->push_back(kHex[c >> 4]);
+    line->push_back(kHex[c & 15]);
+  }
+}
+
+int hexDigit(char c)
+{
+  if (c >= '0' && c <= '9')
+    return c - '0';
+  if (c >= 'a' && c <= 'f')
+    return c - 'a' + 10;
+  return -1;
+}
+
+//--------------------------------------------
+// Parses a stored line: the hex key, then the
+// number of boxes and their corners
+//--------------------------------------------
+bool parseEntry(const char* line, string* key, vector<Box>* boxes)
+{
+  const char* p = line;
+  key->clear();
+  for (; hexDigit(p[0]) >= 0 && hexDigit(p[1]) >= 0; p += 2)
+    key->push_back(char(hexDigit(p[0]) << 4 | hexDigit(p[1])));
+  if (key->empty() || *p != ' ')
+    return false;
+
+  char* end;
+  long n = std::strtol(p, &end, 10);
+  if (end == p || n <= 0)
+    return false;
+  p = end;
+  boxes->clear();
+  for (long i = 0; i < n; ++i) {
+    long corner[4];
+    for (int k = 0; k < 4; ++k) {
+      corner[k] = std::strtol(p, &end, 10);
+      if (end == p || corner[k] < 0)
+        return false;
+      p = end;
+    }
+    Box box = { int(corner[0]), int(corner[1]), int(corner[2]), int(corner[3]) };
+    if (box.topLeftRow > box.bottomRightRow || box.topLeftColumn > box.bottomRightColumn)
+      return false;
+    boxes->push_back(box);
+  }
+  return true;
+}
+
+long long cost(const vector<Box>& boxes)
+{
+  long long cost = 0;
+  foreach(const Box& box, boxes) cost += box.cost();
+  return cost;
+}
+
+bool sameBox(const Box& b1, const Box& b2)
+{
+  return b1.topLeftRow == b2.topLeftRow && b1.topLeftColumn == b2.topLeftColumn
+         && b1.bottomRightRow == b2.bottomRightRow
+         && b1.bottomRightColumn == b2.bottomRightColumn;
+}
+
+//--------------------------------------------
+// true iff there are at most maxRectangles boxes,
+// all inside a numRows X numColumns field and
+// pairwise disjoint
+//--------------------------------------------
+bool isPacking(size_t numRows, size_t numColumns, int maxRectangles,
+               const vector<Box>& boxes)
+{
+  if (maxRectangles < 0 || boxes.size() > size_t(maxRectangles))
+    return false;
+  for (size_t i = 0; i < boxes.size(); ++i) {
+    const Box& b = boxes[i];
+    if (b.topLeftRow < 0 || b.topLeftColumn < 0
+        || b.bottomRightRow >= int(numRows) || b.bottomRightColumn >= int(numColumns))
+      return false;
+    for (size_t j = 0; j < i; ++j) {
+      const Box& other = boxes[j];
+      if (b.topLeftRow <= other.bottomRightRow && other.topLeftRow <= b.bottomRightRow
+          && b.topLeftColumn <= other.bottomRightColumn
+          && other.topLeftColumn <= b.bottomRightColumn)
+        return false;
+    }
+  }
+  return true;
+}
+
+//--------------------------------------------
+// true iff the boxes are a covering of the
+// field under the constraint: a packing (see
+// above) holding every strawberry
+//--------------------------------------------
+bool isCovering(const Field& field, int maxRectangles, const vector<Box>& boxes)
+{
+  if (!isPacking(field.numRows(), field.numColumns(), maxRectangles, boxes))
+    return false;
+  size_t weight = 0;
+  foreach(const Box& b, boxes) {
+    weight += field.weightOfRectangle(b.topLeftRow, b.topLeftColumn,
+                                      b.bottomRightRow, b.bottomRightColumn);
+  }
+  // the boxes are disjoint, so they cover each strawberry at most once
+  return weight == field.strawberries().size();
+}
+
+//--------------------------------------------
+// As isCovering(), for a stored entry: the
+// canonical image, its dimensions and the
+// constraint are decoded from the key (see
+// ResultCache::canonicalize())
+//--------------------------------------------
+bool isStoredCovering(const string& key, const vector<Box>& boxes)
+{
+  uint32_t rows, columns;
+  int32_t maxRectangles;
+  const size_t header = sizeof(rows) + sizeof(columns) + sizeof(maxRectangles);
+  if (key.size() < header)
+    return false;
+  std::memcpy(&rows, key.data(), sizeof(rows));
+  std::memcpy(&columns, key.data() + sizeof(rows), sizeof(columns));
+  std::memcpy(&maxRectangles, key.data() + sizeof(rows) + sizeof(columns),
+              sizeof(maxRectangles));
+  const size_t cells = size_t(rows)*columns;
+  if (key.size() != header + (cells + 63)/64*sizeof(uint64_t)
+      || !isPacking(rows, columns, maxRectangles, boxes))
+    return false;
+
+  vector<uint64_t> bits((cells + 63)/64);
+  if (!bits.empty())
+    std::memcpy(&bits[0], key.data() + header, bits.size()*sizeof(uint64_t));
+  size_t strawberries = 0;
+  foreach(uint64_t word, bits) strawberries += __builtin_popcountll(word);
+  foreach(const Box& b, boxes) {
+    for (int row = b.topLeftRow; row <= b.bottomRightRow; ++row) {
+      for (int column = b.topLeftColumn; column <= b.bottomRightColumn; ++column) {
+        size_t bit = size_t(row)*columns + column;
+        strawberries -= (bits[bit/64] >> (bit % 64)) & 1;
+      }
+    }
+  }
+  return strawberries == 0;
+}
+}  // end anon namespace
+
+ResultCache::ResultCache(const string& path)
+  : m_store(NULL), m_path(path)
+{
+  if (!m_path.empty()) {
+    load();
+    m_store = std::fopen(m_path.c_str(), "a");
+  }
+}
+
+ResultCache::~ResultCache()
+{
+  if (m_store)
+    std::fclose(m_store);
+}
+
+//--------------------------------------------
+// The key of a layout is its bounding box
+// dimensions, the constraint and the bitmap of
+// the box under the symmetry that gives the
+// least key. Keys compare exactly, so distinct
+// layouts never share an entry.
+//--------------------------------------------
+bool ResultCache::canonicalize(const Field& field, int maxRectangles,
+                               string* key, Frame* frame)
+{
+  const vector<Cell>& strawberries = field.strawberries();
+  if (strawberries.empty())
+    return false;
+
+  // bounding box; strawberries are in row-major order
+  int top = strawberries.front().first;
+  int bottom = strawberries.back().first;
+  int left = strawberries.front().second;
+  int right = left;
+  foreach(const Cell& s, strawberries) {
+    left = std::min(left, s.second);
+    right = std::max(right, s.second);
+  }
+  const size_t M = bottom - top + 1;
+  const size_t N = right - left + 1;
+
+  vector<uint64_t> bits;
+  string image;
+  key->clear();
+  for (int g = 0; g < kNumSymmetries; ++g) {
+    size_t rows = M;
+    size_t columns = N;
+    if (swapsAxes(Symmetry(g)))
+      swap(rows, columns);
+    bits.assign((rows*columns + 63)/64, 0);
+    foreach(const Cell& s, strawberries) {
+      int row = s.first - top;
+      int column = s.second - left;
+      transformCell(Symmetry(g), M, N, &row, &column);
+      size_t bit = row*columns + column;
+      bits[bit/64] |= uint64_t(1) << (bit % 64);
+    }
+
+    image.clear();
+    appendBytes(&image, uint32_t(rows));
+    appendBytes(&image, uint32_t(columns));
+    appendBytes(&image, int32_t(maxRectangles));
+    foreach(uint64_t word, bits) appendBytes(&image, word);
+    if (key->empty() || image < *key) {
+      key->swap(image);
+      frame->symmetry = g;
+    }
+  }
+  frame->topRow = top;
+  frame->leftColumn = left;
+  frame->numRows = M;
+  frame->numColumns = N;
+  return true;
+}
+
+bool ResultCache::find(const Field& field, int maxRectangles, Covering* covering)
+{
+  string key;
+  Frame frame;
+  if (!canonicalize(field, maxRectangles, &key, &frame))
+    return false;
+
+  vector<Box> boxes;
+  {
+    boost::lock_guard<boost::mutex> lock(m_mutex);
+    Entries::const_iterator it = m_entries.find(key);
+    if (it == m_entries.end())
+      return false;
+    boxes = it->second;
+  }
+
+  // from the canonical image back to the bounding box, then the field
+  const Symmetry g = Symmetry(frame.symmetry);
+  size_t rows = frame.numRows;
+  size_t columns = frame.numColumns;
+  if (swapsAxes(g))
+    swap(rows, columns);
+  Covering recalled;
+  foreach(const Box& stored, boxes) {
+    // a damaged store may not match the layout
+    if (stored.bottomRightRow >= int(rows) || stored.bottomRightColumn >= int(columns))
+      return forget(key, boxes);
+    Box box = transformBox(inverse(g), rows, columns, stored);
+    box.topLeftRow += frame.topRow;
+    box.bottomRightRow += frame.topRow;
+    box.topLeftColumn += frame.leftColumn;
+    box.bottomRightColumn += frame.leftColumn;
+    recalled.add(box);
+  }
+  if (!isCovering(field, maxRectangles, recalled.boxes()))
+    return forget(key, boxes);
+  recalled.order(field);
+  *covering = recalled;
+  return true;
+}
+
+//--------------------------------------------
+// Drops an entry that turned out not to be a
+// covering of its layout, unless it has been
+// replaced meanwhile, so that the next covering
+// inserted takes its place. Returns false, for
+// a miss.
+//--------------------------------------------
+bool ResultCache::forget(const string& key, const vector<Box>& boxes)
+{
+  boost::lock_guard<boost::mutex> lock(m_mutex);
+  Entries::iterator it = m_entries.find(key);
+  if (it != m_entries.end() && it->second.size() == boxes.size()
+      && std::equal(boxes.begin(), boxes.end(), it->second.begin(), sameBox))
+    m_entries.erase(it);
+  return false;
+}
+
+void ResultCache::insert(const Field& field, int maxRectangles, const Covering& covering)
+{
+  string key;
+  Frame frame;
+  if (covering.empty() || !canonicalize(field, maxRectangles, &key, &frame))
+    return;
+
+  const Symmetry g = Symmetry(frame.symmetry);
+  vector<Box> boxes;
+  foreach(Box box, covering.boxes()) {
+    box.topLeftRow -= frame.topRow;
+    box.bottomRightRow -= frame.topRow;
+    box.topLeftColumn -= frame.leftColumn;
+    box.bottomRightColumn -= frame.leftColumn;
+    // only coverings inside the bounding box carry over to other copies
+    if (box.topLeftRow < 0 || box.topLeftColumn < 0
+        || box.bottomRightRow >= int(frame.numRows)
+        || box.bottomRightColumn >= int(frame.numColumns))
+      return;
+    boxes.push_back(transformBox(g, frame.numRows, frame.numColumns, box));
+  }
+
+  boost::lock_guard<boost::mutex> lock(m_mutex);
+  Entries::iterator it = m_entries.find(key);
+  if (it != m_entries.end() && cost(it->second) <= covering.cost())
+    return;
+  m_entries[key].swap(boxes);
+  append(key, m_entries[key]);
+}
+
+void ResultCache::load()
+{
+  std::FILE* file = std::fopen(m_path.c_str(), "r");
+  if (!file)
+    return;
+  string line;
+  string key;
+  vector<Box> boxes;
+  char buffer[4096];
+  while (std::fgets(buffer, sizeof(buffer), file)) {
+    line += buffer;
+    if (line.empty() || line[line.size() - 1] != '\n')
+      continue;
+    if (parseEntry(line.c_str(), &key, &boxes) && isStoredCovering(key, boxes)) {
+      Entries::iterator it = m_entries.find(key);
+      if (it == m_entries.end() || cost(boxes) < cost(it->second))
+        m_entries[key].swap(boxes);
+    }
+    line.clear();
+  }
+  std::fclose(file);
+}
+
+void ResultCache::append(const string& key, const vector<Box>& boxes)
+{
+  if (!m_store)
+    return;
+  string line;
+  appendHex(&line, key);
+  char number[64];
+  int length = snprintf(number, sizeof(number), " %zu", boxes.size());
+  line.append(number, length);
+  foreach(const Box& box, boxes) {
+    length = snprintf(number, sizeof(number), " %d %d %d %d",
+                      box.topLeftRow, box.topLeftColumn,
+                      box.bottomRightRow, box.bottomRightColumn);
+    line.append(number, length);
+  }
+  line.push_back('\n');
+  std::fwrite(line.data(), 1, line.size(), m_store);
+  std::fflush(m_store);
+}
+
+#undef foreach
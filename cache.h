@@ -0,0 +1,102 @@
+// -----------------------------------------------------------
+//  File: cache.h
+//  Author: Gregory Rehbein
+//
+//  ResultCache class declaration. Remembers the best covering
+//  found for each field layout and cardinality constraint, so
+//  that a layout seen before is answered without running the
+//  optimizer again.
+//
+//  Fields are keyed by a canonical form that is invariant
+//  under translation and under the dihedral group D4: the
+//  strawberries are cropped to their bounding box, and of the
+//  8 images of the crop (see symmetry.h) the one with the
+//  least encoding is the key. Coverings are stored in the
+//  frame of that image and mapped back onto each field that
+//  recalls them, so translated, rotated and mirrored copies
+//  of a layout share one entry.
+//
+//  With a store path, entries are loaded from the file when
+//  the cache is opened and every new or improved entry is
+//  appended to it, one line per entry, so the cache persists
+//  across runs. A later line for a key replaces an earlier
+//  one if it is cheaper. Damaged lines are skipped: every entry
+//  loaded must be a covering of the layout its key encodes, and
+//  a recalled covering is checked against the field again
+//  before it is returned. An entry that fails is a miss, and is
+//  dropped so that the next covering found replaces it.
+//
+//  The cache is shared by the workers of a batch; its methods
+//  are thread-safe.
+//
+//  Copyright (C) 2012 Gregory Rehbein <gmrehbein@gmail.com>
+// -----------------------------------------------------------
+
+#ifndef CACHE_H
+#define CACHE_H
+
+#include <cstdio>
+#include <string>
+#include <vector>
+#include <boost/thread/mutex.hpp>
+#include <boost/unordered_map.hpp>
+#include <boost/utility.hpp>
+#include "covering.h"
+
+class Field;
+
+class ResultCache : boost::noncopyable
+{
+public:
+  //--------------------------------
+  // Opens the cache, loading and then
+  // appending to the store at path;
+  // an empty path keeps the cache in
+  // memory only
+  //--------------------------------
+  explicit ResultCache(const std::string& path);
+  ~ResultCache();
+
+  //--------------------------------
+  // If the layout of the field has a
+  // covering under the constraint,
+  // stores it, mapped onto the field
+  // and in label order, in *covering
+  // and returns true
+  //--------------------------------
+  bool find(const Field& field, int maxRectangles, Covering* covering);
+
+  //--------------------------------
+  // Remembers the covering of the field
+  // unless a covering as cheap is
+  // already known
+  //--------------------------------
+  void insert(const Field& field, int maxRectangles, const Covering& covering);
+
+private:
+  //--------------------------------
+  // Placement of a field's layout
+  // relative to its canonical image
+  //--------------------------------
+  struct Frame {
+    int topRow;       // of the bounding box
+    int leftColumn;
+    size_t numRows;   // of the bounding box
+    size_t numColumns;
+    int symmetry;     // maps the box onto the canonical image
+  };
+
+  static bool canonicalize(const Field& field, int maxRectangles,
+                           std::string* key, Frame* frame);
+  bool forget(const std::string& key, const std::vector<Box>& boxes);
+  void load();
+  void append(const std::string& key, const std::vector<Box>& boxes);
+
+  typedef boost::unordered_map<std::string, std::vector<Box> > Entries;
+  Entries m_entries;
+  boost::mutex m_mutex;
+  std::FILE* m_store;
+  std::string m_path;
+};
+
+#endif // CACHE_H
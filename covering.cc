@@ -0,0 +1,117 @@
+// -----------------------------------------------------------
+//  File: covering.cc
+//  Author: Gregory Rehbein
+//
+//  Copyright (C) 2012 Gregory Rehbein <gmrehbein@gmail.com>
+// -----------------------------------------------------------
+
+// Self
+#include "covering.h"
+
+// C
+#include <cstdio>
+#include <cstring>
+
+// C++
+#include <algorithm>
+#include <string>
+
+#include "field.h"
+
+using std::string;
+
+namespace
+{
+char alphabet[] = {
+  'A', 'B', 'C', 'D', 'E', 'F', 'G', 'H', 'I',
+  'J', 'K', 'L', 'M', 'N', 'O', 'P', 'Q', 'R',
+  'S', 'T', 'U', 'V', 'W', 'X', 'Y', 'Z',
+  'a', 'b', 'c', 'd', 'e', 'f', 'g', 'h', 'i',
+  'j', 'k', 'l', 'm', 'n', 'o', 'p', 'q', 'r',
+  's', 't', 'u', 'v', 'w', 'x', 'y', 'z'
+};
+
+struct BetterBox {
+  const Field* field;
+  explicit BetterBox(const Field* f) : field(f) {}
+  bool operator()(const Box& b1, const Box& b2) const {
+    size_t w1 = field->weightOfRectangle(b1.topLeftRow, b1.topLeftColumn,
+                                         b1.bottomRightRow, b1.bottomRightColumn);
+    size_t w2 = field->weightOfRectangle(b2.topLeftRow, b2.topLeftColumn,
+                                         b2.bottomRightRow, b2.bottomRightColumn);
+    return w1*b2.cost() > w2*b1.cost();
+  }
+};
+}  // end anon namespace
+
+Covering::Covering()
+{
+}
+
+long long Covering::cost() const
+{
+  long long cost = 0;
+  for (size_t i = 0; i < m_boxes.size(); ++i)
+    cost += m_boxes[i].cost();
+  return cost;
+}
+
+void Covering::order(const Field& field)
+{
+  std::stable_sort(m_boxes.begin(), m_boxes.end(), BetterBox(&field));
+}
+
+size_t Covering::labelWidth(size_t cardinality)
+{
+  size_t width = 1;
+  for (size_t labels = sizeof(alphabet); labels < cardinality; labels *= sizeof(alphabet))
+    ++width;
+  return width;
+}
+
+void Covering::label(size_t index, size_t width, char* cell)
+{
+  for (size_t i = width; i-- > 0; index /= sizeof(alphabet))
+    cell[i] = alphabet[index % sizeof(alphabet)];
+}
+
+void Covering::render(std::string* block, size_t numRows, size_t numColumns) const
+{
+  char header[64];
+  int length = snprintf(header, sizeof(header), "Cardinality:%zu\nCost:%lld\n",
+                        m_boxes.size(), cost());
+  block->append(header, length);
+  const size_t cellWidth = labelWidth(m_boxes.size());
+  block->append(numColumns*cellWidth, '=');
+  block->push_back('\n');
+
+  // rows of the field, each followed by a newline
+  const size_t stride = numColumns*cellWidth + 1;
+  const size_t grid = block->size();
+  block->append(numRows*stride, '.');
+  for (size_t row = 0; row < numRows; ++row)
+    (*block)[grid + row*stride + numColumns*cellWidth] = '\n';
+  string cell(cellWidth, ' ');
+  for (size_t k = 0; k < m_boxes.size(); ++k) {
+    const Box& b = m_boxes[k];
+    const size_t width = b.bottomRightColumn - b.topLeftColumn + 1;
+    label(k, cellWidth, &cell[0]);
+    for (int row = b.topLeftRow; row <= b.bottomRightRow; ++row) {
+      char* first = &(*block)[grid + row*stride + b.topLeftColumn*cellWidth];
+      if (cellWidth == 1) {
+        memset(first, cell[0], width);
+      } else {
+        for (size_t j = 0; j < width; ++j)
+          memcpy(first + j*cellWidth, cell.data(), cellWidth);
+      }
+    }
+  }
+  block->push_back('\n');
+}
+
+void Covering::write(std::ostream& out, size_t numRows, size_t numColumns) const
+{
+  string block;
+  render(&block, numRows, numColumns);
+  out.write(block.data(), block.size());
+}
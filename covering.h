@@ -0,0 +1,99 @@
+// -----------------------------------------------------------
+//  File: covering.h
+//  Author: Gregory Rehbein
+//
+//  Box and Covering declarations. A Covering is the result of
+//  an optimization: a disjoint set of rectangles given by
+//  their corners, in label order. Coverings are independent
+//  of the optimizer's arenas, so they outlive the run that
+//  produced them and can be mapped, compared and rendered.
+//
+//  Copyright (C) 2012 Gregory Rehbein <gmrehbein@gmail.com>
+// -----------------------------------------------------------
+
+#ifndef COVERING_H
+#define COVERING_H
+
+#include <cstddef>
+#include <ostream>
+#include <string>
+#include <vector>
+
+class Field;
+
+struct Box {
+  int topLeftRow;
+  int topLeftColumn;
+  int bottomRightRow;
+  int bottomRightColumn;
+
+  inline size_t area() const {
+    return size_t(bottomRightRow - topLeftRow + 1)*size_t(bottomRightColumn - topLeftColumn + 1);
+  }
+  inline size_t cost() const {
+    return 10 + area();
+  }
+};
+
+class Covering
+{
+public:
+  Covering();
+
+  inline void add(const Box& box) {
+    m_boxes.push_back(box);
+  }
+  inline const std::vector<Box>& boxes() const {
+    return m_boxes;
+  }
+  inline size_t size() const {
+    return m_boxes.size();
+  }
+  inline bool empty() const {
+    return m_boxes.empty();
+  }
+  long long cost() const;
+
+  //--------------------------------
+  // Puts the boxes in label order:
+  // descending weight-to-cost ratio
+  // in the field, as Optimizer::label(),
+  // keeping the order of ties
+  //--------------------------------
+  void order(const Field& field);
+
+  //--------------------------------
+  // Labels are A-Z then a-z. Up to 52
+  // rectangles each cell is one label
+  // character; beyond that it is as
+  // many as the cardinality needs, as
+  // the base 52 digits of the index
+  // (AA, AB, ...), so labels never run
+  // out. labelWidth() is the number of
+  // characters per cell, and label()
+  // writes that many for the index-th
+  // rectangle to cell.
+  //--------------------------------
+  static size_t labelWidth(size_t cardinality);
+  static void label(size_t index, size_t width, char* cell);
+
+  //--------------------------------
+  // Appends the cardinality, cost and
+  // labeled field of numRows X numColumns
+  // to *block as one contiguous block,
+  // painting each rectangle by its corners.
+  // Cells are labelWidth() characters
+  // wide, empty cells all '.'.
+  //--------------------------------
+  void render(std::string* block, size_t numRows, size_t numColumns) const;
+
+  //--------------------------------
+  // Renders and writes the block to out
+  //--------------------------------
+  void write(std::ostream& out, size_t numRows, size_t numColumns) const;
+
+private:
+  std::vector<Box> m_boxes;
+};
+
+#endif // COVERING_H
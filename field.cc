@@ -0,0 +1,104 @@
+// -----------------------------------------------------------
+//  File: field.cc
+//  Author: Gregory Rehbein
+//
+//  Copyright (C) 2012 Gregory Rehbein <gmrehbein@gmail.com>
+// -----------------------------------------------------------
+
+// Self
+#include "field.h"
+
+// C
+#include <cstring>
+
+// C++
+#include <algorithm>
+
+using std::vector;
+using std::make_pair;
+
+Field::Field()
+  : m_wordsPerRow(0), m_rows(0), m_numRows(0), m_numColumns(0),
+    m_stride(1), m_wordsPerColumn(0)
+{
+}
+
+//--------------------------------------
+// Appends a row of empty cells; the first
+// row sets the width of the field, and
+// cells past it are dropped
+//--------------------------------------
+void Field::beginRow(size_t length)
+{
+  if (m_rows == 0) {
+    m_numColumns = length;
+    m_wordsPerRow = (length + 63)/64;
+  }
+  m_cells.resize(m_cells.size() + m_wordsPerRow, 0);
+  ++m_rows;
+}
+
+void Field::addRow(const vector<int>& row)
+{
+  beginRow(row.size());
+  const int m = m_rows - 1;
+  uint64_t* cells = &m_cells[m*m_wordsPerRow];
+  for (size_t n = 0; n < row.size() && n < m_numColumns; ++n) {
+    if (row[n]) {
+      cells[n >> 6] |= uint64_t(1) << (n & 63);
+      m_strawberries.push_back(make_pair(m, int(n)));
+    }
+  }
+}
+
+void Field::addRow(const char* row, size_t length)
+{
+  beginRow(length);
+  const int m = m_rows - 1;
+  uint64_t* cells = &m_cells[m*m_wordsPerRow];
+  const char* end = row + std::min(length, m_numColumns);
+  for (const char* p = row; (p = static_cast<const char*>(memchr(p, '@', end - p))); ++p) {
+    size_t n = p - row;
+    cells[n >> 6] |= uint64_t(1) << (n & 63);
+    m_strawberries.push_back(make_pair(m, int(n)));
+  }
+}
+
+void Field::index()
+{
+  m_numRows = m_rows;
+  m_stride = m_numColumns + 1;
+  m_wordsPerColumn = (m_numRows + 63)/64;
+
+  // assign() reuses the capacity kept by clear()
+  m_summedArea.assign((m_numRows + 1)*m_stride, 0);
+  m_rowPrefix.assign(m_numRows*m_stride, 0);
+  m_occupiedRows.assign(m_numColumns*m_wordsPerColumn, 0);
+  for (size_t i = 0; i < m_numRows; ++i) {
+    int* prefix = &m_rowPrefix[i*m_stride];
+    const int* above = &m_summedArea[i*m_stride];
+    int* summed = &m_summedArea[(i + 1)*m_stride];
+    int rowSum = 0;
+    for (size_t j = 0; j < m_numColumns; ++j) {
+      const int cell = at(i, j);
+      rowSum += cell;
+      prefix[j + 1] = rowSum;
+      summed[j + 1] = above[j + 1] + rowSum;
+      if (cell)
+        m_occupiedRows[j*m_wordsPerColumn + (i >> 6)] |= uint64_t(1) << (i & 63);
+    }
+  }
+}
+
+void Field::clear()
+{
+  m_cells.clear();
+  m_strawberries.clear();
+  m_summedArea.clear();
+  m_rowPrefix.clear();
+  m_occupiedRows.clear();
+  m_wordsPerRow = m_rows = 0;
+  m_numRows = m_numColumns = 0;
+  m_stride = 1;
+  m_wordsPerColumn = 0;
+}
@@ -0,0 +1,162 @@
+// -----------------------------------------------------------
+//  File: field.h
+//  Author: Gregory Rehbein
+//
+//  Field class declaration. A Field is one strawberry field
+//  read from the input, together with the indices the
+//  optimizer queries: a summed-area table, per-row column
+//  prefix counts and per-column row occupancy. Fields are
+//  immutable once indexed and are passed explicitly to the
+//  Optimizer and to Rectangle, so separate fields can be
+//  optimized concurrently.
+//
+//  Cells are stored as packed bit rows, 64 cells to a word,
+//  and the strawberries as a flat array in row-major order.
+//  The indices are flat arrays as well: the summed-area table
+//  and the row prefix counts are row-major with a stride of
+//  one more than the number of columns, and the row occupancy
+//  is packed bit columns. clear() keeps the capacity of all of
+//  them, so a Field reused across the fields of an input
+//  allocates nothing per row, per column or per strawberry
+//  once it has grown.
+//
+//  Copyright (C) 2012 Gregory Rehbein <gmrehbein@gmail.com>
+// -----------------------------------------------------------
+
+#ifndef FIELD_H
+#define FIELD_H
+
+#include <cstddef>
+#include <stdint.h>
+#include <vector>
+#include <utility>
+
+class Field
+{
+public:
+  Field();
+
+  //------------------------------------------
+  // Appends a row of n cells, 1 for a strawberry
+  // and 0 otherwise
+  //------------------------------------------
+  void addRow(const std::vector<int>& row);
+
+  //------------------------------------------
+  // Appends a row of length characters of the
+  // input, in which '@' is a strawberry
+  //------------------------------------------
+  void addRow(const char* cells, size_t length);
+
+  //------------------------------------------
+  // Called once the field has been read in: sets
+  // the dimensions and builds the summed-area
+  // table and row indices.
+  //------------------------------------------
+  void index();
+
+  void clear();
+
+  inline bool empty() const {
+    return m_rows == 0;
+  }
+  inline size_t numRows() const {
+    return m_numRows;
+  }
+  inline size_t numColumns() const {
+    return m_numColumns;
+  }
+  inline int at(size_t row, size_t column) const {
+    return (m_cells[row*m_wordsPerRow + (column >> 6)] >> (column & 63)) & 1;
+  }
+
+  //------------------------------------------
+  // (row, column) of each strawberry, in
+  // row-major order
+  //------------------------------------------
+  inline const std::vector<std::pair<int, int> >& strawberries() const {
+    return m_strawberries;
+  }
+
+  //----------------------------------
+  // Number of strawberries contained
+  // within the rectangle determined by
+  // the 4 coordinates. O(1) lookup into
+  // the summed-area table.
+  //-----------------------------------
+  inline size_t weightOfRectangle
+  (int topLeftRow, int topLeftColumn, int bottomRightRow, int bottomRightColumn) const {
+    // optimization: use unchecked [] access
+    const int* top = &m_summedArea[topLeftRow*m_stride];
+    const int* bottom = &m_summedArea[(bottomRightRow + 1)*m_stride];
+    return bottom[bottomRightColumn + 1] - top[bottomRightColumn + 1]
+           - bottom[topLeftColumn] + top[topLeftColumn];
+  }
+
+  //-----------------------------------
+  // Number of strawberries in row 'row'
+  // between the two columns, inclusive.
+  //-----------------------------------
+  inline size_t weightOfRowStrip(int row, int leftColumn, int rightColumn) const {
+    const int* prefix = &m_rowPrefix[row*m_stride];
+    return prefix[rightColumn + 1] - prefix[leftColumn];
+  }
+
+  //-----------------------------------
+  // true iff each of the four edges of
+  // the rectangle holds a strawberry, so
+  // that no smaller rectangle covers the
+  // same strawberries. O(1).
+  //-----------------------------------
+  inline bool isTight
+  (int topLeftRow, int topLeftColumn, int bottomRightRow, int bottomRightColumn) const {
+    return weightOfRowStrip(topLeftRow, topLeftColumn, bottomRightColumn)
+           && weightOfRowStrip(bottomRightRow, topLeftColumn, bottomRightColumn)
+           && weightOfRectangle(topLeftRow, topLeftColumn, bottomRightRow, topLeftColumn)
+           && weightOfRectangle(topLeftRow, bottomRightColumn, bottomRightRow, bottomRightColumn);
+  }
+
+  //------------------------------------------
+  // wordsPerColumn() words of 64 bits, in which
+  // bit i (bit i % 64 of word i / 64) is set iff
+  // there is a strawberry at (i, column).
+  //------------------------------------------
+  inline const uint64_t* occupiedRows(size_t column) const {
+    return &m_occupiedRows[column*m_wordsPerColumn];
+  }
+  inline size_t wordsPerColumn() const {
+    return m_wordsPerColumn;
+  }
+
+private:
+  void beginRow(size_t length);
+
+  std::vector<uint64_t> m_cells;
+  size_t m_wordsPerRow;
+  size_t m_rows;  // rows added so far
+  std::vector<std::pair<int, int> > m_strawberries;
+  size_t m_numRows;
+  size_t m_numColumns;
+
+  size_t m_stride;  // m_numColumns + 1
+
+  //------------------------------------------
+  // Summed-area table (integral image) of the
+  // field: m_summedArea[i*m_stride + j] is the
+  // number of strawberries in rows [0, i) and
+  // columns [0, j).
+  //------------------------------------------
+  std::vector<int> m_summedArea;
+
+  //------------------------------------------
+  // Per-row column prefix counts:
+  // m_rowPrefix[i*m_stride + j] is the number
+  // of strawberries in row i, columns [0, j).
+  //------------------------------------------
+  std::vector<int> m_rowPrefix;
+
+  size_t m_wordsPerColumn;
+  std::vector<uint64_t> m_occupiedRows;
+};
+
+#endif // FIELD_H
@@ -0,0 +1,209 @@
+// -----------------------------------------------------------
+//  File: fieldgen.cc
+//  Author: Gregory Rehbein
+//
+//  Seeded generator of benchmark strawberry fields, written to
+//  stdout in the input format of strawberryfields. The same
+//  seed yields the same fields on every platform.
+//
+//  Layouts:
+//    sparse       - each cell holds a strawberry with p = 0.05
+//    dense        - each cell holds a strawberry with p = 0.5
+//    clustered    - a few dense blobs on an empty field
+//    checkerboard - a checkerboard patch, as in the second
+//                   field of strawberries.txt
+//    worst        - isolated strawberries on every other row
+//                   and column under a tight cardinality
+//                   constraint, which maximizes the greedy
+//                   result set and the forced joins of the
+//                   local search
+//
+//  Copyright (C) 2012 Gregory Rehbein <gmrehbein@gmail.com>
+// -----------------------------------------------------------
+
+// C
+#include <stdint.h>
+
+// C++
+#include <iostream>
+#include <string>
+#include <vector>
+
+// Boost
+#include <boost/program_options.hpp>
+
+using std::cout;
+using std::string;
+using std::vector;
+
+namespace po = boost::program_options;
+
+namespace
+{
+const int kRows = 50;
+const int kColumns = 50;
+
+//--------------------------------------------
+// xorshift64*: portable, unlike rand()
+//--------------------------------------------
+class Random
+{
+public:
+  explicit Random(uint64_t seed) : m_state(seed ? seed : 0x9e3779b97f4a7c15ULL) {}
+  inline uint64_t next() {
+    m_state ^= m_state >> 12;
+    m_state ^= m_state << 25;
+    m_state ^= m_state >> 27;
+    return m_state * 2685821657736338717ULL;
+  }
+  // uniform in [lo, hi]
+  inline int uniform(int lo, int hi) {
+    return lo + int(next() % uint64_t(hi - lo + 1));
+  }
+  inline bool bernoulli(double p) {
+    return (next() >> 11) * (1.0 / 9007199254740992.0) < p;
+  }
+
+private:
+  uint64_t m_state;
+};
+
+typedef vector<string> Grid;
+
+Grid emptyGrid()
+{
+  return Grid(kRows, string(kColumns, '.'));
+}
+
+Grid uniform(Random& random, double p)
+{
+  Grid grid = emptyGrid();
+  for (int i = 0; i < kRows; ++i)
+    for (int j = 0; j < kColumns; ++j)
+      if (random.bernoulli(p))
+        grid[i][j] = '@';
+  return grid;
+}
+
+Grid clustered(Random& random)
+{
+  Grid grid = emptyGrid();
+  const int blobs = random.uniform(3, 8);
+  for (int b = 0; b < blobs; ++b) {
+    const int row = random.uniform(0, kRows - 1);
+    const int column = random.uniform(0, kColumns - 1);
+    const int radius = random.uniform(2, 7);
+    for (int i = row - radius; i <= row + radius; ++i) {
+      for (int j = column - radius; j <= column + radius; ++j) {
+        if (i < 0 || i >= kRows || j < 0 || j >= kColumns)
+          continue;
+        if ((i - row)*(i - row) + (j - column)*(j - column) <= radius*radius
+            && random.bernoulli(0.7))
+          grid[i][j] = '@';
+      }
+    }
+  }
+  return grid;
+}
+
+Grid checkerboard(Random& random)
+{
+  Grid grid = emptyGrid();
+  const int height = random.uniform(10, kRows);
+  const int width = random.uniform(10, kColumns);
+  const int top = random.uniform(0, kRows - height);
+  const int left = random.uniform(0, kColumns - width);
+  for (int i = top; i < top + height; ++i)
+    for (int j = left; j < left + width; ++j)
+      if ((i + j) % 2 == 0)
+        grid[i][j] = '@';
+  return grid;
+}
+
+Grid worst(Random& random)
+{
+  Grid grid = emptyGrid();
+  const int top = random.uniform(0, 1);
+  const int left = random.uniform(0, 1);
+  for (int i = top; i < kRows; i += 2)
+    for (int j = left; j < kColumns; j += 2)
+      grid[i][j] = '@';
+  return grid;
+}
+
+void write(const Grid& grid, int maxRectangles, bool first)
+{
+  if (!first)
+    cout << "\n";
+  cout << maxRectangles << "\n";
+  for (size_t i = 0; i < grid.size(); ++i)
+    cout << grid[i] << "\n";
+}
+}  // end anon namespace
+
+int main(int argc, char* argv[])
+{
+  po::options_description desc("Options");
+  uint64_t seed;
+  int count;
+  string layout;
+  try {
+    desc.add_options()
+    ("help,h", "show help message")
+    ("seed,s", po::value<uint64_t>(&seed)->default_value(2012), "random seed")
+    ("count,n", po::value<int>(&count)->default_value(2), "fields per layout")
+    ("layout,l", po::value<string>(&layout)->default_value("all"),
+     "sparse, dense, clustered, checkerboard, worst or all");
+
+    po::variables_map vm;
+    po::store(po::parse_command_line(argc, argv, desc), vm);
+    po::notify(vm);
+
+    if (vm.count("help")) {
+      cout << "Usage: fieldgen [options]\n";
+      cout << desc;
+      return 1;
+    }
+  }
+
+  catch (std::exception& e) {
+    cout << e.what() << "\n";
+    cout << "Usage: fieldgen [options]\n";
+    cout << desc;
+    return 1;
+  }
+
+  const char* layouts[] = { "sparse", "dense", "clustered", "checkerboard", "worst" };
+  Random random(seed);
+  bool first = true;
+  bool known = false;
+  for (size_t k = 0; k < sizeof(layouts)/sizeof(layouts[0]); ++k) {
+    if (layout != "all" && layout != layouts[k])
+      continue;
+    known = true;
+    for (int n = 0; n < count; ++n) {
+      const string name = layouts[k];
+      Grid grid;
+      int maxRectangles = random.uniform(10, 40);
+      if (name == "sparse")
+        grid = uniform(random, 0.05);
+      else if (name == "dense")
+        grid = uniform(random, 0.5);
+      else if (name == "clustered")
+        grid = clustered(random);
+      else if (name == "checkerboard")
+        grid = checkerboard(random);
+      else {
+        grid = worst(random);
+        maxRectangles = 10;
+      }
+      write(grid, maxRectangles, first);
+      first = false;
+    }
+  }
+  if (!known) {
+    std::cerr << "unknown layout " << layout << "\n";
+    return 1;
+  }
+  return 0;
+}
@@ -8,28 +8,24 @@
 // Self
 #include "global.h"
 
+// C
+#include <cstdlib>
+
 using std::string;
-using std::vector;
-using std::set;
-using std::pair;
 
 string Global::inFile;
 string Global::outFile;
-vector<vector<int> > Global::field;
-set<pair<int,int> > Global::strawberries;
+string Global::statsFile;
 
-size_t Global::numRows = 0;
-size_t Global::numColumns = 0;
+char* Global::AlignedAllocator::malloc(const size_type bytes)
+{
+  void* block = NULL;
+  if (posix_memalign(&block, 64, bytes) != 0)
+    return NULL;
+  return static_cast<char*>(block);
+}
 
-size_t Global::weightOfRectangle
-(int topLeftRow, int topLeftColumn, int bottomRightRow, int bottomRightColumn)
+void Global::AlignedAllocator::free(char* const block)
 {
-  size_t weight = 0;
-  for (int i = topLeftRow; i <= bottomRightRow; ++i) {
-    for (int j = topLeftColumn; j <= bottomRightColumn; ++j) {
-      // optimization: use unchecked [] access
-      weight += Global::field[i][j];
-    }
-  }
-  return weight;
+  std::free(block);
 }
@@ -8,39 +8,26 @@
 #ifndef GLOBAL_H
 #define GLOBAL_H
 
+#include <cstddef>
 #include <string>
-#include <vector>
-#include <set>
-#include <utility>
-#include <boost/pool/singleton_pool.hpp>
-#include <boost/utility.hpp>
-#include "rectangle.h"
 
 struct Global {
   static std::string inFile;
   static std::string outFile;
-  static std::vector<std::vector<int> > field;
-  static std::set<std::pair<int, int> > strawberries;
-
-  //----------------------------------
-  // Number of strawberries contained
-  // within the rectangle determined by
-  // the 4 coordinates.
-  //-----------------------------------
-  static size_t weightOfRectangle
-  (int topLeftRow, int topLeftColumn, int bottomRightRow, int bottomRightColumn);
-
-  static size_t numRows;
-  static size_t numColumns;
+  static std::string statsFile;
 
   //--------------------------------------------------
-  // All rectangles generated by the optimizer are
-  // created using the Global::rectanglePool interface.
-  // All memory for the rectangles is released at the end
-  // of an optimization run.
+  // User allocator for the rectangle arenas owned by
+  // each Optimizer. Hands out cache-line aligned blocks
+  // so that each Rectangle, and in debug builds the Span
+  // inside it, is aligned.
   //--------------------------------------------------
-  typedef struct {} tag_for_pool;
-  static boost::singleton_pool< tag_for_pool, sizeof(Rectangle)> rectanglePool;
+  struct AlignedAllocator {
+    typedef std::size_t size_type;
+    typedef std::ptrdiff_t difference_type;
+    static char* malloc(const size_type bytes);
+    static void free(char* const block);
+  };
 };
 
 #endif
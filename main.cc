@@ -6,41 +6,510 @@
 // -----------------------------------------------------------
 
 // C
-#include <cstdlib>
+#include <cerrno>
+#include <csignal>
+#include <cstdio>
+#include <cstring>
+#include <unistd.h>
 
 // C++
 #include <iostream>
 #include <fstream>
+#include <sstream>
 #include <vector>
 #include <string>
 
 // Boost
+#include <boost/bind/bind.hpp>
+#include <boost/foreach.hpp>
 #include <boost/program_options.hpp>
+#include <boost/ptr_container/ptr_vector.hpp>
+#include <boost/scoped_ptr.hpp>
+#include <boost/thread/locks.hpp>
+#include <boost/thread/mutex.hpp>
+#include <boost/utility.hpp>
 
+#include "binary.h"
+#include "branchandbound.h"
+#include "cache.h"
+#include "covering.h"
+#include "field.h"
+#include "multistart.h"
 #include "optimizer.h"
+#include "portfolio.h"
+#include "reader.h"
+#include "service.h"
 #include "global.h"
+#include "sink.h"
+#include "threadpool.h"
+#include "timer.h"
 
 using std::string;
 using std::cout;
-using std::ifstream;
 using std::ofstream;
-using std::make_pair;
+using std::ostream;
 using std::vector;
-using std::ios_base;
+using boost::placeholders::_1;
+using boost::placeholders::_2;
+
+#define foreach BOOST_FOREACH
 
 namespace po = boost::program_options;
 
+namespace
+{
+//--------------------------------------------
+// A field of the input file together with its
+// cardinality constraint, and, in batch mode,
+// the rendered covering and its cost
+//--------------------------------------------
+struct Job {
+  Field field;
+  size_t index;
+  int maxRectangles;
+  string output;
+  string statistics;
+  long long cost;
+  Job() : index(0), maxRectangles(0), cost(0) {}
+};
+
+//--------------------------------------------
+// Solver settings shared by every field
+//--------------------------------------------
+struct Settings {
+  size_t candidateCapacity;
+  size_t tileSize;
+  size_t threads;
+  double deadline;
+  double exactBudget;
+  bool decompose;
+  bool statistics;
+  double timeLimit;
+  size_t maxMoves;
+  ResultCache* cache;  // NULL without --cache
+  bool sweep;
+  size_t restarts;
+  uint64_t seed;
+  double noise;
+  size_t perturbations;
+  bool binary;  // records in the compact format (see binary.h)
+};
+
+void configure(Optimizer* optimizer, const Settings& settings)
+{
+  optimizer->setCandidateCapacity(settings.candidateCapacity);
+  optimizer->setTileSize(settings.tileSize);
+  optimizer->setThreads(settings.threads);
+  optimizer->setDecomposition(settings.decompose);
+  optimizer->setStatistics(settings.statistics);
+  optimizer->setTimeLimit(settings.timeLimit);
+  optimizer->setMaxMoves(settings.maxMoves);
+}
+
+void configure(Portfolio* portfolio, const Settings& settings)
+{
+  portfolio->setCandidateCapacity(settings.candidateCapacity);
+  portfolio->setTileSize(settings.tileSize);
+  portfolio->setThreads(settings.threads);
+  portfolio->setDecomposition(settings.decompose);
+  portfolio->setStatistics(settings.statistics);
+  portfolio->setTimeLimit(settings.timeLimit);
+  portfolio->setMaxMoves(settings.maxMoves);
+  portfolio->setDeadline(settings.deadline);
+}
+
+void configure(MultiStart* multiStart, const Settings& settings)
+{
+  multiStart->setStarts(settings.restarts);
+  multiStart->setSeed(settings.seed);
+  multiStart->setNoise(settings.noise);
+  multiStart->setPerturbations(settings.perturbations);
+  multiStart->setCandidateCapacity(settings.candidateCapacity);
+  multiStart->setTileSize(settings.tileSize);
+  multiStart->setThreads(settings.threads);
+  multiStart->setDecomposition(settings.decompose);
+  multiStart->setStatistics(settings.statistics);
+  multiStart->setTimeLimit(settings.timeLimit);
+  multiStart->setMaxMoves(settings.maxMoves);
+}
+
+//--------------------------------------------
+// A heuristic solver and, with --exact, the
+// branch and bound search it warm starts
+//--------------------------------------------
+template <class Solver>
+class Worker : boost::noncopyable
+{
+public:
+  explicit Worker(const Settings& settings) : m_settings(settings), m_recalled(false) {
+    configure(&m_solver, settings);
+    m_exact.setTimeBudget(settings.exactBudget);
+  }
+
+  //--------------------------------
+  // Optimizes the field of the job,
+  // appends the labeled covering to
+  // *block and, with --stats, a JSON line
+  // of statistics to *statistics, and
+  // returns the cost of the covering
+  //--------------------------------
+  long long optimize(const Job& job, std::string* block, ostream* statistics) {
+    long long cost = solve(job, block);
+    if (statistics) {
+      const Field& field = job.field;
+      *statistics << "{\"field\":" << job.index
+                  << ",\"rows\":" << field.numRows()
+                  << ",\"columns\":" << field.numColumns()
+                  << ",\"strawberries\":" << field.strawberries().size()
+                  << ",\"maxRectangles\":" << job.maxRectangles
+                  << ",\"cost\":" << cost;
+      if (m_settings.cache)
+        *statistics << ",\"cached\":" << (m_recalled ? "true" : "false");
+      *statistics << ",\"statistics\":";
+      (m_recalled ? Statistics() : m_solver.statistics()).write(*statistics);
+      *statistics << "}\n";
+    }
+    return cost;
+  }
+
+  inline bool statistics() const {
+    return m_settings.statistics;
+  }
+
+private:
+  //--------------------------------
+  // With --cache, a layout seen before
+  // is recalled instead of optimized,
+  // and every covering found is offered
+  // to the cache
+  //--------------------------------
+  long long solve(const Job& job, std::string* block) {
+    if (m_settings.sweep)
+      return sweep(job, block);
+
+    const Field& field = job.field;
+    ResultCache* cache = m_settings.cache;
+    Covering covering;
+    m_recalled = false;
+    if (cache) {
+      double start_time = wallTime();
+      m_recalled = cache->find(field, job.maxRectangles, &covering);
+      if (m_recalled) {
+        printf("recalled %zu X %zu field of %zu strawberries in %.6f seconds\n",
+               field.numRows(), field.numColumns(), field.strawberries().size(),
+               wallTime() - start_time);
+        emit(job, covering, block);
+        return covering.cost();
+      }
+    }
+
+    long long cost = optimize(job, block, &covering);
+    if (cache)
+      cache->insert(field, job.maxRectangles, covering);
+    return cost;
+  }
+
+  //--------------------------------
+  // With --sweep, writes the covering
+  // at each cardinality limit from 1 to
+  // the constraint, and returns the cost
+  // of the last
+  //--------------------------------
+  long long sweep(const Job& job, std::string* block) {
+    const Field& field = job.field;
+    double start_time = wallTime();
+    vector<Covering> coverings;
+    m_solver.setMaxRectangles(job.maxRectangles);
+    m_solver.sweep(field, &coverings);
+    printf("swept %zu X %zu field of %zu strawberries over %zu cardinalities in %.6f seconds\n",
+           field.numRows(), field.numColumns(), field.strawberries().size(),
+           coverings.size(), wallTime() - start_time);
+    foreach(const Covering& covering, coverings)
+      emit(job, covering, block);
+    return coverings.empty() ? 0 : coverings.back().cost();
+  }
+
+  long long optimize(const Job& job, std::string* block, Covering* result) {
+    m_solver.setMaxRectangles(job.maxRectangles);
+    if (m_settings.exactBudget <= 0) {
+      long long cost = m_solver.run(job.field, NULL, result);
+      emit(job, *result, block);
+      return cost;
+    }
+
+    const Field& field = job.field;
+    double start_time = wallTime();
+    Covering& covering = *result;
+    m_solver.solve(field, &covering);
+    long long heuristicCost = covering.cost();
+    m_exact.setMaxRectangles(job.maxRectangles);
+    bool optimal = m_exact.improve(field, &covering);
+    printf("optimized %zu X %zu field of %zu strawberries in %.6f seconds: "
+           "heuristic cost %lld, cost %lld, lower bound %lld, gap %lld%s (%zu nodes)\n",
+           field.numRows(), field.numColumns(), field.strawberries().size(),
+           wallTime() - start_time, heuristicCost, covering.cost(),
+           m_exact.lowerBound(), covering.cost() - m_exact.lowerBound(),
+           optimal ? ", optimal" : "", m_exact.nodes());
+    emit(job, covering, block);
+    return covering.cost();
+  }
+
+  //--------------------------------
+  // Appends the covering of the job to
+  // *block, as text or, with --binary,
+  // as a record
+  //--------------------------------
+  void emit(const Job& job, const Covering& covering, std::string* block) const {
+    const Field& field = job.field;
+    if (m_settings.binary)
+      encodeCovering(block, job.index, field.numRows(), field.numColumns(), covering);
+    else
+      covering.render(block, field.numRows(), field.numColumns());
+  }
+
+  const Settings& m_settings;
+  Solver m_solver;
+  BranchAndBound m_exact;
+  bool m_recalled;  // the last field was answered by the cache
+};
+
+//--------------------------------------------
+// Batch mode: hands the coverings and statistics
+// of finished jobs to the sink in input order,
+// as soon as every earlier job has finished
+//--------------------------------------------
+struct Publisher {
+  vector<Job>* jobs;
+  vector<char> finished;
+  size_t next;
+  OutputSink* output;
+  ostream* statistics;
+  long long totalCost;
+  boost::mutex mutex;
+
+  Publisher(vector<Job>* j, OutputSink* o, ostream* s)
+    : jobs(j), finished(j->size(), 0), next(0), output(o), statistics(s), totalCost(0) {}
+
+  void publish(size_t i) {
+    boost::lock_guard<boost::mutex> lock(mutex);
+    finished[i] = 1;
+    for (; next < jobs->size() && finished[next]; ++next) {
+      Job& job = (*jobs)[next];
+      output->write(&job.output);
+      if (statistics)
+        *statistics << job.statistics;
+      totalCost += job.cost;
+    }
+  }
+};
+
+//--------------------------------------------
+// Batch mode task: optimizes job i on the
+// solver owned by the worker
+//--------------------------------------------
+template <class Solver>
+void optimizeJob(boost::ptr_vector<Worker<Solver> >* workers, Publisher* publisher,
+                 size_t i, size_t worker)
+{
+  Job& job = (*publisher->jobs)[i];
+  Worker<Solver>& solver = (*workers)[worker];
+  std::ostringstream statistics;
+  job.cost = solver.optimize(job, &job.output, solver.statistics() ? &statistics : NULL);
+  job.statistics = statistics.str();
+  publisher->publish(i);
+}
+
+//--------------------------------------------
+// Optimizes the fields of the input one at a
+// time on *solver, writing each covering as
+// soon as it is done, and returns the total
+// cost of the coverings
+//--------------------------------------------
+template <class Solver>
+long long optimizeStream(FieldReader& strawberryFile, OutputSink& output, ostream* statistics,
+                   Worker<Solver>* solver)
+{
+  long long totalCost = 0;
+  Job job;
+  std::string block;
+  while (strawberryFile.next(&job.field, &job.maxRectangles)) {
+    totalCost += solver->optimize(job, &block, statistics);
+    output.write(&block);
+    job.maxRectangles = 0;
+    ++job.index;
+  }
+  return totalCost;
+}
+
+void writeTotalCost(OutputSink& output, long long totalCost, const Settings& settings)
+{
+  string block;
+  if (settings.binary) {
+    encodeTotalCost(&block, totalCost);
+  } else {
+    std::ostringstream total;
+    total << "Total Cost: " << totalCost << "\n";
+    block = total.str();
+  }
+  output.write(&block);
+}
+
+//--------------------------------------------
+// Optimizes every field of the input, one at
+// a time or on a pool of workers, writes the
+// coverings and statistics in input order and
+// returns the total cost of the coverings
+//--------------------------------------------
+template <class Solver>
+long long optimizeFields(FieldReader& strawberryFile, OutputSink& output, ostream* statistics,
+                   const Settings& settings, size_t workers)
+{
+  if (workers == 0) {
+    Worker<Solver> solver(settings);
+    return optimizeStream(strawberryFile, output, statistics, &solver);
+  }
+
+  vector<Job> jobs;
+  jobs.push_back(Job());
+  while (strawberryFile.next(&jobs.back().field, &jobs.back().maxRectangles)) {
+    jobs.push_back(Job());
+    jobs.back().index = jobs.size() - 1;
+  }
+  jobs.pop_back();
+
+  ThreadPool pool(workers);
+  boost::ptr_vector<Worker<Solver> > solvers;
+  for (size_t i = 0; i < pool.size(); ++i)
+    solvers.push_back(new Worker<Solver>(settings));
+  Publisher publisher(&jobs, &output, statistics);
+  pool.parallelFor(jobs.size(), boost::bind(optimizeJob<Solver>, &solvers, &publisher, _1, _2));
+  return publisher.totalCost;
+}
+
+//--------------------------------------------
+// Service mode: optimizes the fields of stdin,
+// or of each connection to the socket at
+// socketPath, on one solver kept warm across
+// all of them. Each covering is streamed back
+// as soon as it is done, and the total cost
+// when the stream ends. On stdin the coverings
+// go to stdout and progress to stderr.
+//--------------------------------------------
+template <class Solver>
+int serveFields(ostream* statistics, const Settings& settings, const string& socketPath)
+{
+  // a client that hangs up must not take the service down
+  signal(SIGPIPE, SIG_IGN);
+  Worker<Solver> solver(settings);
+  if (socketPath.empty()) {
+    std::fflush(stdout);
+    int out = dup(STDOUT_FILENO);
+    dup2(STDERR_FILENO, STDOUT_FILENO);
+    FieldReader input(STDIN_FILENO);
+    OutputSink output(out);
+    writeTotalCost(output, optimizeStream(input, output, statistics, &solver), settings);
+    return 0;
+  }
+
+  ServiceSocket listener(socketPath);
+  if (!listener.listening()) {
+    cout << "cannot listen at " << socketPath << "\n";
+    return 1;
+  }
+  for (;;) {
+    int connection = listener.accept();
+    if (connection < 0) {
+      std::cerr << "cannot accept at " << socketPath << ": " << std::strerror(errno) << "\n";
+      return 1;
+    }
+    {
+      FieldReader input(connection);
+      OutputSink output(dup(connection));
+      writeTotalCost(output, optimizeStream(input, output, statistics, &solver), settings);
+      if (statistics)
+        statistics->flush();
+    }
+    close(connection);
+  }
+}
+
+}  // end anon namespace
+
+
 int main(int argc, char* argv[])
 {
 // process options
   po::options_description desc("Options");
+  Settings settings;
+  size_t workers;
+  bool symmetries = false;
+  bool async = false;
+  bool cache = false;
+  string cacheFile;
+  bool serve = false;
+  string socketPath;
+  string convertFile;
   try {
     desc.add_options()
     ("help,h", "show help message")
     ("file,f", po::value<string>
      (&Global::inFile)->default_value("strawberries.txt"), "input file")
     ("output,o", po::value<string>
-     (&Global::outFile)->default_value("optimal_covering.txt"), "output file");
+     (&Global::outFile)->default_value("optimal_covering.txt"), "output file")
+    ("candidates,c", po::value<size_t>
+     (&settings.candidateCapacity)->default_value(Optimizer::kDefaultCandidateCapacity),
+     "max candidate rectangles held at once (0 = all)")
+    ("tile", po::value<size_t>
+     (&settings.tileSize)->default_value(0),
+     "large-field mode: candidate rectangles, and the joins the local search tries first, span at most this many rows and columns (0 = no bound)")
+    ("threads,t", po::value<size_t>
+     (&settings.threads)->default_value(1), "threads used for local search")
+    ("time-limit,l", po::value<double>
+     (&settings.timeLimit)->default_value(0),
+     "seconds per field after which local search only makes the joins the cardinality constraint needs (0 = none)")
+    ("max-moves,m", po::value<size_t>
+     (&settings.maxMoves)->default_value(0),
+     "local search moves per field after which only the joins the cardinality constraint needs are made (0 = none)")
+    ("symmetries,s", "optimize all 8 symmetries of each field and keep the best")
+    ("deadline,d", po::value<double>
+     (&settings.deadline)->default_value(0),
+     "with --symmetries, seconds after which symmetries still running are abandoned (0 = none)")
+    ("regions,r", "split each field into independent regions and optimize them separately")
+    ("exact,e", po::value<double>
+     (&settings.exactBudget)->default_value(0),
+     "seconds of branch and bound search for an optimal covering after the heuristic (0 = off)")
+    ("stats", po::value<string>
+     (&Global::statsFile)->default_value(""),
+     "write per-phase times and counters of each field as JSON lines to this file")
+    ("jobs,j", po::value<size_t>
+     (&workers)->default_value(0),
+     "read all fields up front and optimize them on this many workers (0 = one at a time)")
+    ("async-output,a", "write the output file on a background thread")
+    ("sweep,w", "write the best covering at every cardinality limit from 1 to that of each field, from one local search")
+    ("cache,k", "recall the covering of a field whose layout, up to translation and symmetry, was seen before")
+    ("cache-file", po::value<string>
+     (&cacheFile)->default_value(""),
+     "with --cache, load the cache from and save it to this file")
+    ("restarts,n", po::value<size_t>
+     (&settings.restarts)->default_value(1),
+     "optimize each field from this many starts, with seeded tie-breaking and ratio noise, and keep the best")
+    ("seed", po::value<uint64_t>
+     (&settings.seed)->default_value(0),
+     "with --restarts, seed of the randomized starts; the same seed gives the same coverings")
+    ("noise", po::value<double>
+     (&settings.noise)->default_value(0.05),
+     "with --restarts, relative noise added to the weight-to-cost ratios of the randomized starts")
+    ("perturbations", po::value<size_t>
+     (&settings.perturbations)->default_value(MultiStart::kDefaultPerturbations),
+     "with --restarts, rounds of split-and-reoptimize moves on the starts still within 1% of the best")
+    ("serve", "keep running and optimize the fields of stdin as they arrive, streaming each covering to stdout")
+    ("socket", po::value<string>
+     (&socketPath)->default_value(""),
+     "keep running and optimize the fields of each connection to this Unix domain socket, streaming the coverings back")
+    ("binary,b", "write the coverings as compact binary records of their corners instead of painted fields")
+    ("convert", po::value<string>
+     (&convertFile)->default_value(""),
+     "write the coverings of this binary output file to the output file as text, and exit");
 
     po::positional_options_description p;
     p.add("file", 1);
@@ -49,6 +518,22 @@ int main(int argc, char* argv[])
     po::store(po::command_line_parser(argc, argv).options(desc).positional(p).run(), vm);
     po::notify(vm);
 
+    symmetries = vm.count("symmetries");
+    async = vm.count("async-output");
+    cache = vm.count("cache") || !cacheFile.empty();
+    settings.sweep = vm.count("sweep");
+    if (settings.sweep && (cache || settings.exactBudget > 0))
+      throw po::error("--sweep cannot be combined with --cache or --exact");
+    settings.binary = vm.count("binary");
+    serve = vm.count("serve") || !socketPath.empty();
+    if (serve && workers > 0)
+      throw po::error("--serve and --socket cannot be combined with --jobs");
+    if (settings.restarts == 0)
+      throw po::error("--restarts must be at least 1");
+    if (settings.restarts > 1 && symmetries)
+      throw po::error("--restarts cannot be combined with --symmetries");
+    settings.decompose = vm.count("regions");
+    settings.statistics = !Global::statsFile.empty();
     if (vm.count("help")) {
       cout << "Usage: strawberryfields [options]\n";
       cout << desc;
@@ -63,57 +548,39 @@ int main(int argc, char* argv[])
     return 1;
   }
 
-  Optimizer optimizer;
-  int maxRectangles;
-  int totalCost = 0;
-
-// input arrays
-  ifstream strawberryFile(Global::inFile.c_str());
-  char line[52];
-  while (strawberryFile.getline(line, 52).good()) {
-    static int m = -1;  // row count
-    if (strawberryFile.gcount() > 1) {
-      if (isdigit(line[0])) {
-        maxRectangles = strtol(line, NULL, 10);
-        optimizer.setMaxRectangles(maxRectangles);
-      } else {
-        // read line into field
-        vector<int> row;
-        ++m;
-        int numColumns = strawberryFile.gcount() - 1;
-        row.reserve(numColumns);
-        for (int n = 0; n < numColumns; ++n) {
-          if ('.' == line[n])
-            row.push_back(0);
-          else if ('@' == line[n]) {
-            row.push_back(1);
-            Global::strawberries.insert(make_pair(m, n));
-          }
-        }
-        Global::field.push_back(row);
-        row.clear();
-      }
-    } else if (!Global::field.empty()) {
-      // we read a newline and are ready to
-      // process the strawberry patch
-      m = -1;
-      Global::numRows = Global::field.size();
-      Global::numColumns = Global::field.at(0).size();
-      totalCost += optimizer.run();
-      Global::field.clear();
-      Global::strawberries.clear();
-      Global::numRows = Global::numColumns = 0;
-    }
+  if (!convertFile.empty()) {
+    OutputSink output(Global::outFile, async);
+    if (convertToText(convertFile, output))
+      return 0;
+    cout << convertFile << " is not a complete binary output file\n";
+    return 1;
   }
-  // handle the last field
-  if (strawberryFile.eof() && !Global::field.empty()) {
-    Global::numRows = Global::field.size();
-    Global::numColumns = Global::field.at(0).size();
-    totalCost += optimizer.run();
+
+  boost::scoped_ptr<ResultCache> resultCache(cache ? new ResultCache(cacheFile) : NULL);
+  settings.cache = resultCache.get();
+  ofstream statisticsFile;
+  if (settings.statistics)
+    statisticsFile.open(Global::statsFile.c_str());
+  ostream* statistics = settings.statistics ? &statisticsFile : NULL;
+  if (serve) {
+    if (symmetries)
+      return serveFields<Portfolio>(statistics, settings, socketPath);
+    if (settings.restarts > 1)
+      return serveFields<MultiStart>(statistics, settings, socketPath);
+    return serveFields<Optimizer>(statistics, settings, socketPath);
   }
-  strawberryFile.close();
-  ofstream output(Global::outFile.c_str(), ios_base::out | ios_base::app);
-  output << "Total Cost: " << totalCost << "\n";
-  output.close();
+
+  FieldReader strawberryFile(Global::inFile);
+  OutputSink output(Global::outFile, async);
+  long long totalCost;
+  if (symmetries)
+    totalCost = optimizeFields<Portfolio>(strawberryFile, output, statistics, settings, workers);
+  else if (settings.restarts > 1)
+    totalCost = optimizeFields<MultiStart>(strawberryFile, output, statistics, settings, workers);
+  else
+    totalCost = optimizeFields<Optimizer>(strawberryFile, output, statistics, settings, workers);
+  writeTotalCost(output, totalCost, settings);
   return 0;
 }
+
+#undef foreach
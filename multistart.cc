@@ -0,0 +1,250 @@
+// -----------------------------------------------------------
+//  File: multistart.cc
+//  Author: Gregory Rehbein
+//
+//  Copyright (C) 2012 Gregory Rehbein <gmrehbein@gmail.com>
+// -----------------------------------------------------------
+
+// Self
+#include "multistart.h"
+
+// C
+#include <cassert>
+#include <cstdio>
+
+// C++
+#include <algorithm>
+
+// Boost
+#include <boost/bind/bind.hpp>
+#include <boost/foreach.hpp>
+
+#include "field.h"
+#include "timer.h"
+
+using std::vector;
+using boost::placeholders::_1;
+using boost::placeholders::_2;
+
+#define foreach BOOST_FOREACH
+
+namespace
+{
+
+//--------------------------------------------------
+// splitmix64 finalizer, as in optimizer.cc
+//--------------------------------------------------
+inline uint64_t mix(uint64_t x)
+{
+  x += 0x9e3779b97f4a7c15ULL;
+  x = (x ^ (x >> 30))*0xbf58476d1ce4e5b9ULL;
+  x = (x ^ (x >> 27))*0x94d049bb133111ebULL;
+  return x ^ (x >> 31);
+}
+
+}  // end anon namespace
+
+const size_t MultiStart::kDefaultStarts;
+const size_t MultiStart::kDefaultPerturbations;
+
+MultiStart::MultiStart()
+  : m_field(NULL), m_maxRectangles(0), m_seed(0), m_noise(0.05),
+    m_perturbations(kDefaultPerturbations)
+{
+  setStarts(kDefaultStarts);
+}
+
+MultiStart::~MultiStart()
+{
+}
+
+void MultiStart::setStarts(size_t starts)
+{
+  assert(starts > 0);
+  m_threads.reset(new ThreadPool(starts));
+  while (m_optimizers.size() < starts)
+    m_optimizers.push_back(new Optimizer);
+  while (m_optimizers.size() > starts)
+    m_optimizers.pop_back();
+  seed();
+}
+
+void MultiStart::setSeed(uint64_t seed)
+{
+  m_seed = seed;
+  this->seed();
+}
+
+void MultiStart::setNoise(double noise)
+{
+  m_noise = noise;
+  seed();
+}
+
+void MultiStart::seed()
+{
+  // Hash the pair (seed, i) rather than use seed + i, which
+  // would make the starts of seeds s and s + 1 overlap.
+  m_optimizers[0].setSeed(0, 0);
+  for (size_t i = 1; i < m_optimizers.size(); ++i)
+    m_optimizers[i].setSeed(mix(mix(m_seed) ^ i), m_noise);
+}
+
+void MultiStart::setPerturbations(size_t rounds)
+{
+  m_perturbations = rounds;
+}
+
+void MultiStart::setMaxRectangles(int m)
+{
+  m_maxRectangles = m;
+}
+
+void MultiStart::setCandidateCapacity(size_t capacity)
+{
+  foreach(Optimizer& optimizer, m_optimizers) optimizer.setCandidateCapacity(capacity);
+}
+
+void MultiStart::setTileSize(size_t tileSize)
+{
+  foreach(Optimizer& optimizer, m_optimizers) optimizer.setTileSize(tileSize);
+}
+
+void MultiStart::setThreads(size_t threads)
+{
+  foreach(Optimizer& optimizer, m_optimizers) optimizer.setThreads(threads);
+}
+
+void MultiStart::setDecomposition(bool decompose)
+{
+  foreach(Optimizer& optimizer, m_optimizers) optimizer.setDecomposition(decompose);
+}
+
+void MultiStart::setStatistics(bool enabled)
+{
+  foreach(Optimizer& optimizer, m_optimizers) optimizer.setStatistics(enabled);
+}
+
+void MultiStart::setTimeLimit(double seconds)
+{
+  foreach(Optimizer& optimizer, m_optimizers) optimizer.setTimeLimit(seconds);
+}
+
+void MultiStart::setMaxMoves(size_t maxMoves)
+{
+  foreach(Optimizer& optimizer, m_optimizers) optimizer.setMaxMoves(maxMoves);
+}
+
+long long MultiStart::run(const Field& field, std::ostream& out)
+{
+  std::string block;
+  long long cost = run(field, &block);
+  out.write(block.data(), block.size());
+  return cost;
+}
+
+long long MultiStart::run(const Field& field, std::string* block, Covering* result)
+{
+  double start_time = wallTime();
+  Covering covering;
+  solve(field, &covering);
+  printf("optimized %zu X %zu field of %zu strawberries from %zu starts in %.6f seconds\n",
+         field.numRows(), field.numColumns(), field.strawberries().size(),
+         m_maxRectangles > 1 ? m_optimizers.size() : size_t(1),
+         wallTime() - start_time);
+  if (block)
+    covering.render(block, field.numRows(), field.numColumns());
+  if (result)
+    *result = covering;
+  m_maxRectangles = 0;
+  return covering.cost();
+}
+
+//--------------------------------------------------------
+// The hull computed under a cardinality constraint of 1
+// does not depend on the candidate order, so only start 0
+// is run.
+//--------------------------------------------------------
+bool MultiStart::solve(const Field& field, Covering* covering)
+{
+  m_field = &field;
+  vector<size_t> starts;
+  const size_t count = m_maxRectangles > 1 ? m_optimizers.size() : 1;
+  for (size_t i = 0; i < count; ++i)
+    starts.push_back(i);
+  m_threads->parallelFor(starts.size(),
+                         boost::bind(&MultiStart::beginStart, this, &starts, _1, _2));
+
+  for (size_t round = 0; round < m_perturbations && m_maxRectangles > 1; ++round) {
+    // drop the starts more than 1% above the best so far
+    long long best = m_optimizers[starts[0]].cost();
+    foreach(size_t i, starts) best = std::min(best, m_optimizers[i].cost());
+    vector<size_t> racing;
+    foreach(size_t i, starts) {
+      if (m_optimizers[i].cost() <= best + best/100)
+        racing.push_back(i);
+    }
+    starts.swap(racing);
+    m_threads->parallelFor(starts.size(),
+                           boost::bind(&MultiStart::perturbStart, this, &starts, _1, _2));
+  }
+
+  // cheapest covering; ties go to the lowest start
+  size_t best = 0;
+  for (size_t i = 1; i < count; ++i) {
+    if (m_optimizers[i].cost() < m_optimizers[best].cost())
+      best = i;
+  }
+  m_statistics.clear();
+  for (size_t i = 0; i < count; ++i) {
+    m_optimizers[i].end(i == best ? covering : NULL);
+    m_statistics += m_optimizers[i].statistics();
+  }
+  m_field = NULL;
+  return true;
+}
+
+bool MultiStart::sweep(const Field& field, vector<Covering>* coverings)
+{
+  m_field = &field;
+  const size_t count = m_maxRectangles > 1 ? m_optimizers.size() : 1;
+  m_sweeps.resize(count);
+  m_threads->parallelFor(count, boost::bind(&MultiStart::sweepStart, this, _1, _2));
+
+  m_statistics.clear();
+  for (size_t i = 0; i < count; ++i)
+    m_statistics += m_optimizers[i].statistics();
+
+  // cheapest covering of each cardinality; ties go to the lowest start
+  *coverings = m_sweeps[0];
+  for (size_t i = 1; i < count; ++i) {
+    for (size_t k = 0; k < coverings->size(); ++k) {
+      if (m_sweeps[i][k].cost() < (*coverings)[k].cost())
+        (*coverings)[k] = m_sweeps[i][k];
+    }
+  }
+  m_field = NULL;
+  m_maxRectangles = 0;
+  return true;
+}
+
+void MultiStart::beginStart(const vector<size_t>* starts, size_t i, size_t)
+{
+  Optimizer& optimizer = m_optimizers[(*starts)[i]];
+  optimizer.setMaxRectangles(m_maxRectangles);
+  optimizer.begin(*m_field);
+}
+
+void MultiStart::perturbStart(const vector<size_t>* starts, size_t i, size_t)
+{
+  m_optimizers[(*starts)[i]].perturb();
+}
+
+void MultiStart::sweepStart(size_t start, size_t)
+{
+  Optimizer& optimizer = m_optimizers[start];
+  optimizer.setMaxRectangles(m_maxRectangles);
+  optimizer.sweep(*m_field, &m_sweeps[start]);
+}
+
+#undef foreach
@@ -0,0 +1,125 @@
+// -----------------------------------------------------------
+//  File: multistart.h
+//  Author: Gregory Rehbein
+//
+//  MultiStart class declaration. Runs the optimizer pipeline
+//  from several starts, one thread each, and keeps the
+//  cheapest covering. Start 0 is the deterministic pipeline;
+//  the others break candidate ties at random and scale each
+//  weight-to-cost ratio by random noise (see
+//  Optimizer::setSeed()), so the greedy phase takes different
+//  paths through the candidates.
+//
+//  After the starts, rounds of perturb-and-reoptimize moves
+//  (see Optimizer::perturb()) run on every start still in the
+//  race. Between rounds the best cost over the starts is
+//  shared, and a start more than 1% above it is dropped.
+//  Rounds run in lockstep and ties go to the lowest start, so
+//  the same seed always gives the same covering, whatever the
+//  scheduling of the threads.
+//
+//  Copyright (C) 2012 Gregory Rehbein <gmrehbein@gmail.com>
+// -----------------------------------------------------------
+
+#ifndef MULTISTART_H
+#define MULTISTART_H
+
+#include <stdint.h>
+#include <ostream>
+#include <string>
+#include <vector>
+#include <boost/ptr_container/ptr_vector.hpp>
+#include <boost/scoped_ptr.hpp>
+#include <boost/utility.hpp>
+#include "covering.h"
+#include "optimizer.h"
+#include "statistics.h"
+#include "threadpool.h"
+
+class Field;
+
+class MultiStart : boost::noncopyable
+{
+public:
+  MultiStart();
+  ~MultiStart();
+
+  //--------------------------------
+  // Same contract as Optimizer::run()
+  //--------------------------------
+  long long run(const Field& field, std::ostream& out);
+  long long run(const Field& field, std::string* block, Covering* result = NULL);
+
+  //--------------------------------
+  // Stores the best covering of the
+  // field over all starts in *covering.
+  // Returns true.
+  //--------------------------------
+  bool solve(const Field& field, Covering* covering);
+
+  //--------------------------------
+  // Optimizer::sweep() of every start,
+  // keeping the cheapest covering of
+  // each cardinality
+  //--------------------------------
+  bool sweep(const Field& field, std::vector<Covering>* coverings);
+
+  void setMaxRectangles(int maxRectangles);
+  void setCandidateCapacity(size_t capacity);
+  void setTileSize(size_t tileSize);
+  void setThreads(size_t threads);
+  void setDecomposition(bool decompose);
+  void setStatistics(bool enabled);
+  void setTimeLimit(double seconds);
+  void setMaxMoves(size_t maxMoves);
+
+  //---------------------------------
+  // Number of starts (at least 1), the
+  // seed they derive their own from and
+  // the ratio noise of the seeded starts.
+  // Start i > 0 is seeded with a hash
+  // of the pair (seed, i).
+  //---------------------------------
+  void setStarts(size_t starts);
+  void setSeed(uint64_t seed);
+  void setNoise(double noise);
+
+  //---------------------------------
+  // Rounds of perturb-and-reoptimize
+  // moves after the starts (0 = none)
+  //---------------------------------
+  void setPerturbations(size_t rounds);
+
+  //---------------------------------
+  // Statistics of the last solve(),
+  // summed over the starts
+  //---------------------------------
+  inline const Statistics& statistics() const {
+    return m_statistics;
+  }
+
+  static const size_t kDefaultStarts = 8;
+  static const size_t kDefaultPerturbations = 16;
+
+private:
+  void seed();
+  void beginStart(const std::vector<size_t>* starts, size_t i, size_t worker);
+  void perturbStart(const std::vector<size_t>* starts, size_t i, size_t worker);
+  void sweepStart(size_t start, size_t worker);
+
+  boost::scoped_ptr<ThreadPool> m_threads;
+  boost::ptr_vector<Optimizer> m_optimizers;
+
+  const Field* m_field;
+  int m_maxRectangles;
+  uint64_t m_seed;
+  double m_noise;
+  size_t m_perturbations;
+
+  // coverings of each cardinality, by start, during a sweep()
+  std::vector<std::vector<Covering> > m_sweeps;
+
+  Statistics m_statistics;
+};
+
+#endif // MULTISTART_H
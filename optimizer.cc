@@ -9,7 +9,6 @@
 #include "optimizer.h"
 
 //  C
-#include <ctime>
 #include <cstdio>
 #include <cassert>
 #include <cstring>
@@ -17,19 +16,23 @@
 
 //  C++
 #include <algorithm>
+#include <list>
 #include <set>
-#include <iostream>
-#include <fstream>
+#include <ostream>
+#include <functional>
 
 //  Boost
-#include <boost/dynamic_bitset.hpp>
+#include <boost/bind/bind.hpp>
 #include <boost/foreach.hpp>
-#include <boost/range/iterator_range.hpp>
 #include <boost/tuple/tuple.hpp>
 
+#include "covering.h"
+#include "field.h"
 #include "global.h"
 #include "rectangle.h"
+#include "regions.h"
 #include "shade.h"
+#include "timer.h"
 
 using std::pair;
 using std::list;
@@ -39,35 +42,16 @@ using std::sort;
 using std::min;
 using std::max;
 using std::fill;
-using std::replace;
-using std::ofstream;
-using std::ios_base;
-using boost::dynamic_bitset;
-using boost::iterator_range;
+using std::greater;
+using std::push_heap;
+using std::pop_heap;
+using boost::placeholders::_1;
+using boost::placeholders::_2;
 
 #define foreach BOOST_FOREACH
 
 namespace
 {
-char alphabet[] = {
-  'A', 'B', 'C', 'D', 'E', 'F', 'G', 'H', 'I',
-  'J', 'K', 'L', 'M', 'N', 'O', 'P', 'Q', 'R',
-  'S', 'T', 'U', 'V', 'W', 'X', 'Y', 'Z',
-  'a', 'b', 'c', 'd', 'e', 'f', 'g', 'h', 'i',
-  'j', 'k', 'l', 'm', 'n', 'o', 'p', 'q', 'r',
-  's', 't', 'u', 'v', 'w', 'x', 'y', 'z'
-};
-
-//------------------------------------------------
-// For a strawberry field of m rows and n columns,
-// returns the total number of rectangles that may be
-// generated from it
-//-----------------------------------------------
-inline size_t maxNumberOfRectangles(size_t m, size_t n)
-{
-  return ((m*n+1)*(m*n)/2 - (m*(m-1))*(n*(n-1))/4);
-}
-
 //-----------------------------------------------------
 // Ordinal type encoding the effect that taking the
 // join of 2 rectangles {R1, R2} from the result set R
@@ -122,6 +106,10 @@ struct Slice {
 // *r3 with respect to *join, in particular whether
 // the intersection is or is not a rectangle.
 //
+// All rectangles are axis-aligned, so the intersection
+// type and the slice are decided from the corners alone
+// in O(1).
+//
 // Note: attempting to accelerate the localSearch() phase by
 // memoizing the intersection types for given triples of
 // rectangles {R1, R2, R3} in a lookup table actually slows
@@ -135,38 +123,60 @@ void determineIntersectionType(const Rectangle* r3, const Rectangle* join, Slice
     s->intersection = kVoid;
   } else if (r3->isSubsetOf(join)) {
     s->intersection = kDecreasing;
+  } else if (r3->differenceIsRectangle(join, &s->topLeftRow, &s->topLeftColumn,
+                                       &s->bottomRightRow, &s->bottomRightColumn)) {
+    // caller will use the corners to generate new Rectangle
+    s->intersection = kNonIncreasing;
   } else {
-    dynamic_bitset<> left_over = r3->span() - join->span();
+    s->intersection = kIncreasing;
+  }
+}
+
+#ifdef CHECK_SPANS
+//--------------------------------------------------------
+// Bitmap implementation of determineIntersectionType(),
+// kept as a debug cross-check of the coordinate predicates.
+// Requires the spans of *r3 and *join to have been made.
+//---------------------------------------------------------
+void determineIntersectionTypeFromSpans(const Field& field, const Rectangle* r3,
+                                        const Rectangle* join, Slice* s)
+{
+  const size_t numColumns = field.numColumns();
+  if (!r3->spanIntersects(join)) {
+    s->intersection = kVoid;
+  } else if (r3->spanIsSubsetOf(join)) {
+    s->intersection = kDecreasing;
+  } else {
+    Span left_over = r3->span() - join->span();
 
     assert(left_over.any());
 
-    dynamic_bitset<> test(r3->span());
-    test.reset();
+    Span test;
 
     set<size_t> rows;
     set<size_t> columns;
 
     size_t pos = left_over.find_first();
-    size_t topLeftColumn = pos % Global::numColumns;
-    size_t topLeftRow = (pos - topLeftColumn)/Global::numColumns;
+    size_t topLeftColumn = pos % numColumns;
+    size_t topLeftRow = (pos - topLeftColumn)/numColumns;
 
     size_t next_index = pos;
     size_t col, row;
-    while (next_index != dynamic_bitset<>::npos) {
+    while (next_index != Span::npos) {
       pos = next_index;
-      col = pos % Global::numColumns;
-      row = (pos - col)/Global::numColumns;
+      col = pos % numColumns;
+      row = (pos - col)/numColumns;
       rows.insert(row);
       columns.insert(col);
       next_index = left_over.find_next(pos);
     }
 
-    size_t bottomRightColumn = pos % Global::numColumns;
-    size_t bottomRightRow = (pos - bottomRightColumn)/Global::numColumns;
+    size_t bottomRightColumn = pos % numColumns;
+    size_t bottomRightRow = (pos - bottomRightColumn)/numColumns;
 
     for (size_t i = topLeftRow; i <= bottomRightRow; ++i)
-      for (size_t j = topLeftColumn; j <= bottomRightColumn; ++j)
-        test.set(i*Global::numColumns + j);
+      test.set(i*numColumns + topLeftColumn,
+               bottomRightColumn - topLeftColumn + 1);
 
     // condition 1: topLeftRow and topLeftColumn must be
     // the min among all rows and columns, resp.
@@ -194,55 +204,530 @@ void determineIntersectionType(const Rectangle* r3, const Rectangle* join, Slice
   }  // end case of non cardinality-decreasing intersections
 }
 
-typedef list<Rectangle*>::iterator ListIterator;
+
+void assertSliceAgreesWithSpans(const Field& field, const Rectangle* r3,
+                                const Rectangle* join, const Slice& s)
+{
+  if (field.numRows()*field.numColumns() > Span::kCapacity)
+    return;
+  Slice check(s.original);
+  determineIntersectionTypeFromSpans(field, r3, join, &check);
+  assert(check.intersection == s.intersection);
+  if (kNonIncreasing == s.intersection) {
+    assert(check.topLeftRow == s.topLeftRow);
+    assert(check.topLeftColumn == s.topLeftColumn);
+    assert(check.bottomRightRow == s.bottomRightRow);
+    assert(check.bottomRightColumn == s.bottomRightColumn);
+  }
+}
+#endif
+
 typedef pair<int, int> strawberry;
 
+//--------------------------------------------------
+// splitmix64 finalizer: a well-mixed hash of x
+//--------------------------------------------------
+inline uint64_t mix(uint64_t x)
+{
+  x += 0x9e3779b97f4a7c15ULL;
+  x = (x ^ (x >> 30))*0xbf58476d1ce4e5b9ULL;
+  x = (x ^ (x >> 27))*0x94d049bb133111ebULL;
+  return x ^ (x >> 31);
+}
+
+//--------------------------------------------------
+// Index of the first set bit at or after from in the
+// packed words of bits, or 64*bits.size() if none
+//--------------------------------------------------
+inline size_t nextSetBit(const vector<uint64_t>& bits, size_t from)
+{
+  size_t w = from >> 6;
+  if (w >= bits.size())
+    return bits.size()*64;
+  uint64_t word = bits[w] & (~uint64_t(0) << (from & 63));
+  while (!word) {
+    if (++w == bits.size())
+      return bits.size()*64;
+    word = bits[w];
+  }
+  return w*64 + __builtin_ctzll(word);
+}
+
+//--------------------------------------------------
+// True if the join of r1 and r2 spans at most span
+// rows and columns; any join fits a span of 0
+//--------------------------------------------------
+inline bool joinFits(const Rectangle* r1, const Rectangle* r2, size_t span)
+{
+  if (span == 0)
+    return true;
+  const int rows = max(r1->bottomRightRow(), r2->bottomRightRow())
+                   - min(r1->topLeftRow(), r2->topLeftRow()) + 1;
+  const int columns = max(r1->bottomRightColumn(), r2->bottomRightColumn())
+                      - min(r1->topLeftColumn(), r2->topLeftColumn()) + 1;
+  return size_t(rows) <= span && size_t(columns) <= span;
+}
+
 }  // end anon namespace
 
+//------------------------------------------------------
+// Entry of the local search shade table: the shade of
+// a pair of rectangles in the result set, and whether
+// it is an admissible move
+//------------------------------------------------------
+struct Optimizer::ShadeEntry {
+  Shade shade;
+  bool admissible;
+  explicit ShadeEntry(const Shade& s)
+    : shade(s), admissible(false) {
+  }
+};
+
+//------------------------------------------------------
+// Best admissible shade found in one chunk of the
+// shade table, and the positions of its pair in the
+// result set, for the parallel min-reduction
+//------------------------------------------------------
+struct Optimizer::BestShade {
+  const Shade* shade;
+  pair<size_t, size_t> rank;
+  BestShade() : shade(NULL) {}
+  inline bool operator<(const BestShade& other) const {
+    if (!other.shade)
+      return shade != NULL;
+    if (!shade)
+      return false;
+    if (*shade < *other.shade)
+      return true;
+    if (*other.shade < *shade)
+      return false;
+    return rank < other.rank;
+  }
+};
+
+const size_t Optimizer::kDefaultCandidateCapacity;
+
 Optimizer::Optimizer()
-  :m_maxRectangles(0)
+  :m_field(NULL), m_maxRectangles(0), m_cancelled(NULL), m_deadline(0),
+   m_interrupted(false), m_timeLimit(0), m_maxMoves(0), m_stopAt(0), m_sweep(NULL),
+   m_seed(0), m_noise(0), m_random(0), m_bestCost(0), m_timing(false),
+   m_candidateCapacity(kDefaultCandidateCapacity), m_tileSize(0),
+   m_decompose(false), m_windowed(false)
 {
+  setThreads(1);
 }
 
 Optimizer::~Optimizer()
 {
   m_rectangles.clear();
-  m_covering.clear();
 }
 
-int Optimizer::run()
+long long Optimizer::run(const Field& field, std::ostream& out)
 {
-  clock_t start_time, end_time;
-  double elapsed_time_seconds;
+  std::string block;
+  long long cost = run(field, &block);
+  out.write(block.data(), block.size());
+  return cost;
+}
 
-  start_time = clock();
+long long Optimizer::run(const Field& field, std::string* block, Covering* result)
+{
+  double start_time = wallTime();
+  Covering covering;
+  solve(field, &covering);
+  printf("optimized %zu X %zu field of %zu strawberries in %.6f seconds\n",
+         field.numRows(), field.numColumns(),
+         field.strawberries().size(), wallTime() - start_time);
+  if (block)
+    covering.render(block, field.numRows(), field.numColumns());
+  if (result)
+    *result = covering;
+  return covering.cost();
+}
+
+bool Optimizer::solve(const Field& field, Covering* covering)
+{
+  m_statistics.clear();
+  const double wall = m_timing ? wallTime() : 0;
+  const double cpu = m_timing ? cpuTime() : 0;
+  m_stopAt = m_timeLimit > 0 ? wallTime() + m_timeLimit : 0;
+
+  bool solved = false;
+  bool completed = false;
+  if (m_decompose && m_maxRectangles > 1) {
+    vector<Box> regions;
+    findRegions(field, &regions);
+    if (regions.size() > 1) {
+      completed = solveRegions(field, regions, covering);
+      solved = completed || m_interrupted;
+      if (solved)
+        m_maxRectangles = 0;
+    }
+  }
+  if (!solved)
+    completed = solveField(field, covering);
+
+  if (m_timing) {
+    m_statistics.wallTime[Statistics::kTotal] = wallTime() - wall;
+    m_statistics.cpuTime[Statistics::kTotal] = cpuTime() - cpu;
+  }
+  return completed;
+}
+
+bool Optimizer::sweep(const Field& field, vector<Covering>* coverings)
+{
+  m_statistics.clear();
+  const double wall = m_timing ? wallTime() : 0;
+  const double cpu = m_timing ? cpuTime() : 0;
+  m_stopAt = m_timeLimit > 0 ? wallTime() + m_timeLimit : 0;
+
+  const size_t K = m_maxRectangles;
+  coverings->assign(K, Covering());
+  m_field = &field;
+  m_interrupted = false;
+  m_result.setBounds(field.numRows(), field.numColumns());
+  if (K == 0 || field.strawberries().empty()) {
+    reset();
+    return true;
+  }
+
+  if (K > 1) {
+    m_sweep = coverings;
+    m_maxRectangles = 1;
+    generateRectangles();
+    greedyMatch();
+    recordSweep();
+    localSearch();
+    m_sweep = NULL;
+    m_result.clear();
+  }
+  {
+    PhaseTimer timer(timing(), Statistics::kHull);
+    computeConvexHull();
+  }
+  const bool completed = !interrupted();
+  if (completed) {
+    Rectangle* hull = *m_result.begin();
+    Box box = { hull->topLeftRow(), hull->topLeftColumn(),
+                hull->bottomRightRow(), hull->bottomRightColumn()
+              };
+    (*coverings)[0] = Covering();
+    (*coverings)[0].add(box);
+
+    // a covering with at most k - 1 rectangles has at most k
+    for (size_t k = 1; k < K; ++k) {
+      Covering& covering = (*coverings)[k];
+      if (covering.empty() || (*coverings)[k - 1].cost() < covering.cost())
+        covering = (*coverings)[k - 1];
+    }
+    foreach(Covering& covering, *coverings) covering.order(field);
+  }
+  reset();
+
+  if (m_timing) {
+    m_statistics.wallTime[Statistics::kTotal] = wallTime() - wall;
+    m_statistics.cpuTime[Statistics::kTotal] = cpuTime() - cpu;
+  }
+  return completed;
+}
+
+//---------------------------------------------------
+// During a sweep, keeps the result set as the covering
+// of its cardinality if it is the cheapest seen
+//---------------------------------------------------
+void Optimizer::recordSweep()
+{
+  const size_t k = m_result.size();
+  if (k == 0 || k > m_sweep->size() || interrupted())
+    return;
+  long long cost = 0;
+  foreach(Rectangle* r, m_result) cost += r->cost();
+  Covering& best = (*m_sweep)[k - 1];
+  if (!best.empty() && best.cost() <= cost)
+    return;
+  best = Covering();
+  foreach(Rectangle* r, m_result) {
+    Box box = { r->topLeftRow(), r->topLeftColumn(),
+                r->bottomRightRow(), r->bottomRightColumn()
+              };
+    best.add(box);
+  }
+}
+
+bool Optimizer::begin(const Field& field)
+{
+  m_statistics.clear();
+  m_stopAt = m_timeLimit > 0 ? wallTime() + m_timeLimit : 0;
+  m_field = &field;
+  m_interrupted = false;
+  m_random = mix(m_seed);
+  m_result.setBounds(field.numRows(), field.numColumns());
+  m_best.clear();
+  m_bestCost = 0;
+  if (field.strawberries().empty())
+    return true;
 
   if (m_maxRectangles > 1) {
     generateRectangles();
     greedyMatch();
     localSearch();
   } else {
+    PhaseTimer timer(timing(), Statistics::kHull);
     computeConvexHull();
   }
-  label();
-  end_time = clock();
-  elapsed_time_seconds = (static_cast<double>(end_time - start_time))
-                         / CLOCKS_PER_SEC;
-  printf("optimized %zu X %zu field of %zu strawberries in %.6f seconds\n",
-         Global::numRows, Global::numColumns,
-         Global::strawberries.size(), elapsed_time_seconds);
-  output();
-  int totalCost = 0;
-  foreach(Rectangle* r, m_result) totalCost += r->cost();
+  if (interrupted())
+    return false;
+  keepBest();
+  return true;
+}
+
+void Optimizer::end(Covering* covering)
+{
+  if (covering) {
+    *covering = Covering();
+    foreach(const Box& box, m_best) covering->add(box);
+    covering->order(*m_field);
+  }
   reset();
-  return totalCost;
+}
+
+bool Optimizer::perturb()
+{
+  if (m_maxRectangles <= 1 || m_best.empty() || interrupted())
+    return false;
+
+  // a rectangle holding at least two strawberries, at random
+  vector<Rectangle*> splittable;
+  foreach(Rectangle* r, m_result) {
+    if (r->weight() > 1)
+      splittable.push_back(r);
+  }
+  if (splittable.empty() || !split(splittable[random() % splittable.size()]))
+    return false;
+  localSearch();
+
+  long long cost = 0;
+  foreach(Rectangle* r, m_result) cost += r->cost();
+  if (!interrupted() && m_result.size() <= m_maxRectangles && cost < m_bestCost) {
+    keepBest();
+    return true;
+  }
+  restoreBest();
+  return false;
+}
+
+//---------------------------------------------------
+// Replaces *r in the result set by the tight hulls of
+// its strawberries on either side of a random cut that
+// leaves strawberries on both
+//---------------------------------------------------
+bool Optimizer::split(Rectangle* r)
+{
+  const int top = r->topLeftRow();
+  const int left = r->topLeftColumn();
+  const int bottom = r->bottomRightRow();
+  const int right = r->bottomRightColumn();
+  const size_t weight = r->weight();
+
+  // cut i splits rows [top, i) from [i, bottom], or columns likewise
+  vector<pair<bool, int> > cuts;
+  for (int i = top + 1; i <= bottom; ++i) {
+    size_t above = m_field->weightOfRectangle(top, left, i - 1, right);
+    if (above > 0 && above < weight)
+      cuts.push_back(pair<bool, int>(true, i));
+  }
+  for (int j = left + 1; j <= right; ++j) {
+    size_t before = m_field->weightOfRectangle(top, left, bottom, j - 1);
+    if (before > 0 && before < weight)
+      cuts.push_back(pair<bool, int>(false, j));
+  }
+  if (cuts.empty())
+    return false;
+
+  const pair<bool, int> cut = cuts[random() % cuts.size()];
+  Box first = cut.first ? tighten(top, left, cut.second - 1, right)
+              : tighten(top, left, bottom, cut.second - 1);
+  Box second = cut.first ? tighten(cut.second, left, bottom, right)
+               : tighten(top, cut.second, bottom, right);
+  m_result.replace(r, newRectangle(first.topLeftRow, first.topLeftColumn,
+                                   first.bottomRightRow, first.bottomRightColumn));
+  m_result.push_back(newRectangle(second.topLeftRow, second.topLeftColumn,
+                                  second.bottomRightRow, second.bottomRightColumn));
+  return true;
+}
+
+//---------------------------------------------------
+// Smallest rectangle within the given one holding the
+// same strawberries; it must hold at least one
+//---------------------------------------------------
+Box Optimizer::tighten(int top, int left, int bottom, int right) const
+{
+  assert(m_field->weightOfRectangle(top, left, bottom, right) > 0);
+  while (!m_field->weightOfRowStrip(top, left, right))
+    ++top;
+  while (!m_field->weightOfRowStrip(bottom, left, right))
+    --bottom;
+  while (!m_field->weightOfRectangle(top, left, bottom, left))
+    ++left;
+  while (!m_field->weightOfRectangle(top, right, bottom, right))
+    --right;
+  Box box = { top, left, bottom, right };
+  return box;
+}
+
+void Optimizer::keepBest()
+{
+  m_best.clear();
+  m_bestCost = 0;
+  foreach(Rectangle* r, m_result) {
+    Box box = { r->topLeftRow(), r->topLeftColumn(),
+                r->bottomRightRow(), r->bottomRightColumn()
+              };
+    m_best.push_back(box);
+    m_bestCost += box.cost();
+  }
+}
+
+void Optimizer::restoreBest()
+{
+  m_result.clear();
+  foreach(const Box& box, m_best) {
+    m_result.push_back(newRectangle(box.topLeftRow, box.topLeftColumn,
+                                    box.bottomRightRow, box.bottomRightColumn));
+  }
+}
+
+//---------------------------------------------------
+// xorshift64*, seeded by begin()
+//---------------------------------------------------
+uint64_t Optimizer::random()
+{
+  m_random ^= m_random >> 12;
+  m_random ^= m_random << 25;
+  m_random ^= m_random >> 27;
+  return m_random*0x2545f4914f6cdd1dULL;
+}
+
+//---------------------------------------------------
+// Optimizes each region on its own, in parallel, and
+// combines the coverings, shifted back to the field.
+// Returns false if a region was interrupted or the
+// combined covering breaks the cardinality constraint.
+//---------------------------------------------------
+bool Optimizer::solveRegions(const Field& field, const vector<Box>& regions,
+                             Covering* covering)
+{
+  while (m_regionOptimizers.size() < m_threads->size())
+    m_regionOptimizers.push_back(new Optimizer);
+  foreach(Optimizer& optimizer, m_regionOptimizers) {
+    optimizer.setCandidateCapacity(m_candidateCapacity);
+    optimizer.setTileSize(m_tileSize);
+    optimizer.setInterrupt(m_cancelled, m_deadline);
+    optimizer.setStatistics(m_timing);
+    optimizer.setMaxMoves(m_maxMoves);
+    // regions share what is left of the time limit
+    optimizer.setTimeLimit(m_stopAt > 0 ? max(m_stopAt - wallTime(), 1e-6) : 0);
+  }
+
+  vector<Field> fields(regions.size());
+  for (size_t i = 0; i < regions.size(); ++i)
+    cropField(field, regions[i], &fields[i]);
+  vector<Covering> coverings(regions.size());
+  vector<char> completed(regions.size(), 0);
+  vector<Statistics> statistics(regions.size());
+  m_threads->parallelFor(regions.size(),
+                         boost::bind(&Optimizer::solveRegion, this, &fields,
+                                     &coverings, &completed, &statistics, _1, _2));
+  foreach(const Statistics& s, statistics) m_statistics += s;
+
+  m_interrupted = std::count(completed.begin(), completed.end(), 0) > 0;
+  size_t cardinality = 0;
+  foreach(const Covering& c, coverings) cardinality += c.size();
+  if (m_interrupted || cardinality > m_maxRectangles)
+    return false;
+
+  *covering = Covering();
+  for (size_t i = 0; i < regions.size(); ++i) {
+    foreach(Box box, coverings[i].boxes()) {
+      box.topLeftRow += regions[i].topLeftRow;
+      box.bottomRightRow += regions[i].topLeftRow;
+      box.topLeftColumn += regions[i].topLeftColumn;
+      box.bottomRightColumn += regions[i].topLeftColumn;
+      covering->add(box);
+    }
+  }
+  covering->order(field);
+  return true;
+}
+
+void Optimizer::solveRegion(const vector<Field>* fields, vector<Covering>* coverings,
+                            vector<char>* completed, vector<Statistics>* statistics,
+                            size_t i, size_t worker)
+{
+  Optimizer& optimizer = m_regionOptimizers[worker];
+  optimizer.setMaxRectangles(m_maxRectangles);
+  (*completed)[i] = optimizer.solve((*fields)[i], &(*coverings)[i]);
+  (*statistics)[i] = optimizer.statistics();
+  (*statistics)[i].wallTime[Statistics::kTotal] = 0;
+  (*statistics)[i].cpuTime[Statistics::kTotal] = 0;
+}
+
+bool Optimizer::solveField(const Field& field, Covering* covering)
+{
+  m_field = &field;
+  m_interrupted = false;
+  m_result.setBounds(field.numRows(), field.numColumns());
+  if (field.strawberries().empty()) {
+    *covering = Covering();
+    reset();
+    return true;
+  }
+
+  if (m_maxRectangles > 1) {
+    generateRectangles();
+    greedyMatch();
+    localSearch();
+  } else {
+    PhaseTimer timer(timing(), Statistics::kHull);
+    computeConvexHull();
+  }
+  const bool completed = !interrupted();
+  if (completed) {
+    label();
+    *covering = Covering();
+    foreach(Rectangle* r, m_result) {
+      Box box = { r->topLeftRow(), r->topLeftColumn(),
+                  r->bottomRightRow(), r->bottomRightColumn()
+                };
+      covering->add(box);
+    }
+  }
+  reset();
+  return completed;
+}
+
+//---------------------------------------------------
+// Polled between units of work; once interrupted, a
+// run stays interrupted until the next solve()
+//---------------------------------------------------
+bool Optimizer::interrupted()
+{
+  if (!m_interrupted && m_cancelled)
+    m_interrupted = *m_cancelled || (m_deadline > 0 && wallTime() > m_deadline);
+  return m_interrupted;
 }
 
 void Optimizer::reset()
 {
   m_result.clear();
-  Global::rectanglePool.purge_memory();
+  m_rectangles.clear();
+  m_windowed = false;
+  for (size_t i = 0; i < m_arenas.size(); ++i) {
+    m_statistics.arenaBytes += m_arenas[i].allocatedBytes();
+    m_arenas[i].release();
+  }
   m_maxRectangles = 0;
+  m_field = NULL;
 }
 
 void Optimizer::setMaxRectangles(int m)
@@ -250,6 +735,115 @@ void Optimizer::setMaxRectangles(int m)
   m_maxRectangles = m;
 }
 
+void Optimizer::setThreads(size_t threads)
+{
+  m_threads.reset(new ThreadPool(threads));
+  m_arenas.clear();
+  for (size_t i = 0; i < m_threads->size(); ++i)
+    m_arenas.push_back(new Arena(sizeof(Rectangle)));
+}
+
+void Optimizer::setStatistics(bool enabled)
+{
+  m_timing = enabled;
+}
+
+//--------------------------------------
+// Statistics charged by PhaseTimers, or
+// NULL if the clocks are disabled
+//--------------------------------------
+Statistics* Optimizer::timing()
+{
+  return m_timing ? &m_statistics : NULL;
+}
+
+void Optimizer::setTimeLimit(double seconds)
+{
+  m_timeLimit = seconds;
+}
+
+void Optimizer::setMaxMoves(size_t maxMoves)
+{
+  m_maxMoves = maxMoves;
+}
+
+void Optimizer::setTileSize(size_t tileSize)
+{
+  m_tileSize = tileSize;
+}
+
+void Optimizer::setSeed(uint64_t seed, double noise)
+{
+  m_seed = seed ? mix(seed) : 0;
+  m_noise = seed ? noise : 0;
+}
+
+bool Optimizer::budgetExhausted(size_t moves) const
+{
+  return (m_maxMoves && moves >= m_maxMoves) || (m_stopAt > 0 && wallTime() > m_stopAt);
+}
+
+void Optimizer::setInterrupt(const boost::atomic<bool>* cancelled, double deadline)
+{
+  m_cancelled = cancelled;
+  m_deadline = deadline;
+}
+
+void Optimizer::setDecomposition(bool decompose)
+{
+  m_decompose = decompose;
+}
+
+void Optimizer::setCandidateCapacity(size_t capacity)
+{
+  m_candidateCapacity = capacity;
+}
+
+const int Optimizer::Candidate::kCornerMask;
+const int Optimizer::Candidate::kWeightShift;
+const size_t Optimizer::Candidate::kWeightMask;
+const int Optimizer::Candidate::kRatioShift;
+const uint64_t Optimizer::Candidate::kRatioMask;
+const uint64_t Optimizer::Candidate::kTieBreakMask;
+
+Optimizer::Candidate Optimizer::Candidate::make(int topLeftRow, int topLeftColumn,
+                                                int bottomRightRow, int bottomRightColumn,
+                                                size_t weight)
+{
+  assert(bottomRightRow <= kCornerMask && bottomRightColumn <= kCornerMask);
+  assert(weight <= kWeightMask);
+  const uint64_t cost = 10 + uint64_t(bottomRightRow - topLeftRow + 1)*(bottomRightColumn - topLeftColumn + 1);
+  const uint64_t ratio = (uint64_t(weight) << 39)/cost;
+  Candidate c;
+  c.key = ratio << kRatioShift | uint64_t(weight) << kWeightShift;
+  c.corners = uint64_t(kCornerMask - topLeftRow) << 48
+              | uint64_t(kCornerMask - topLeftColumn) << 32
+              | uint64_t(kCornerMask - bottomRightRow) << 16
+              | uint64_t(kCornerMask - bottomRightColumn);
+  return c;
+}
+
+//-----------------------------------------------
+// Seeded candidate order. The noise factor and the
+// tie-break bits are drawn from a hash of the seed
+// and the candidate's weight and corners, so the
+// order is still a strict total order, fixed for the
+// run, and windows are regenerated exactly.
+//-----------------------------------------------
+void Optimizer::randomize(Candidate* c) const
+{
+  const uint64_t weight = c->key >> Candidate::kWeightShift & Candidate::kWeightMask;
+  const uint64_t h = mix(m_seed ^ mix(c->corners ^ weight));
+  uint64_t ratio = c->key >> Candidate::kRatioShift;
+  if (m_noise > 0) {
+    const double u = double(h >> 11)/double(uint64_t(1) << 53);
+    const double scaled = ratio*(1 + m_noise*(2*u - 1));
+    ratio = scaled <= 0 ? 0 : min(uint64_t(scaled), Candidate::kRatioMask);
+  }
+  c->key = ratio << Candidate::kRatioShift | weight << Candidate::kWeightShift
+           | (h & Candidate::kTieBreakMask);
+}
+
 //-----------------------------------------------
 // First phase of the optimizer pipeline:
 // For an M X N strawberry field, generate the
@@ -261,32 +855,95 @@ void Optimizer::setMaxRectangles(int m)
 // weight(R_k) == weight (R_k-1).
 // Sort the resulting set of rectangles in order
 // of increasing weight-to-cost ratio.
+//
+// Chains are grown one row at a time: R_k differs
+// from R_k-1 by a single row strip, so its weight is
+// that of R_k-1 plus the strip's count. Only rows whose
+// strip is non-empty are visited, so the work done is
+// proportional to the number of rectangles emitted.
+//
+// Only tight rectangles, each of whose edges holds a
+// strawberry, are kept: any other rectangle ranks below
+// the tight one it shrinks to, which covers the same
+// strawberries at less cost, so the greedy phase would
+// never choose it. The bottom edge of a chain member holds
+// a strawberry by construction, and the other three are
+// checked in O(1) with Field::isTight().
+//
+// With a tile size T, candidates span at most T rows
+// and T columns, so that the work of a pass grows with
+// the area of the field rather than with its number of
+// rectangles; larger rectangles are still reached by the
+// joins of the local search.
+//
+// With a candidate capacity K, only the K best candidates
+// ranking below m_lastDelivered are kept, using a bounded
+// heap whose top is the worst kept candidate. Later
+// windows are regenerated on demand by findNextRectangle()
+// and skip candidates that meet the covering. Returns
+// false if no candidate is left.
 //-----------------------------------------------
-void Optimizer::generateRectangles()
+bool Optimizer::generateRectangles()
 {
-  const int M = Global::numRows;
-  const int N = Global::numColumns;
+  const int M = m_field->numRows();
+  const int N = m_field->numColumns();
+  const int T = m_tileSize ? int(min(m_tileSize, size_t(max(M, N)))) : max(M, N);
+  const size_t K = m_candidateCapacity;
+  const bool covering = !m_covering.empty();
+  PhaseTimer timer(timing(), Statistics::kGenerate);
 
-  m_rectangles.reserve(maxNumberOfRectangles(M, N));
+  m_rectangles.clear();
+  m_rectangles.reserve(K);
 
-  for (int row = 0; row < M; ++row) {
+  // rows with a strawberry in columns [col, right]
+  const size_t W = m_field->wordsPerColumn();
+  vector<uint64_t> occupied(W);
+  for (int row = 0; row < M && !interrupted(); ++row) {
+    const size_t lastRow = min(row + T, M) - 1;
     for (int col = 0; col < N; ++col) {
-      for (int right = col; right < N; ++right) {
+      fill(occupied.begin(), occupied.end(), 0);
+      for (int right = col; right < min(col + T, N); ++right) {
+        const uint64_t* rows = m_field->occupiedRows(right);
+        for (size_t w = 0; w < W; ++w)
+          occupied[w] |= rows[w];
+        // a chain whose top edge is empty holds no tight rectangle
+        if (!m_field->weightOfRowStrip(row, col, right))
+          continue;
         //  begin generating chain
         size_t weight = 0;
-        for (int down = row; down < M; ++down) {
-          size_t w = Global::weightOfRectangle(row, col, down, right);
-          if (w > weight) {
-            Rectangle* r =  new(Global::rectanglePool.malloc())
-            Rectangle(row, col, down, right, w);
-            m_rectangles.push_back(r);
-            weight = w;
+        size_t down = nextSetBit(occupied, row);
+        for (; down <= lastRow; down = nextSetBit(occupied, down + 1)) {
+          weight += m_field->weightOfRowStrip(down, col, right);
+          if (!m_field->isTight(row, col, down, right))
+            continue;
+          ++m_statistics.rectanglesGenerated;
+          Candidate c = Candidate::make(row, col, down, right, weight);
+          if (m_seed)
+            randomize(&c);
+          if (m_windowed && !(c < m_lastDelivered))
+            continue;
+          if (covering && isCovered(row, col, down, right))
+            continue;
+          if (!K) {
+            m_rectangles.push_back(c);
+          } else if (m_rectangles.size() < K) {
+            m_rectangles.push_back(c);
+            push_heap(m_rectangles.begin(), m_rectangles.end(), greater<Candidate>());
+          } else if (m_rectangles.front() < c) {
+            pop_heap(m_rectangles.begin(), m_rectangles.end(), greater<Candidate>());
+            m_rectangles.back() = c;
+            push_heap(m_rectangles.begin(), m_rectangles.end(), greater<Candidate>());
           }
         }
       }
     }
   }
-  sort(m_rectangles.begin(), m_rectangles.end(), Rectangle::better);
+  sort(m_rectangles.begin(), m_rectangles.end());
+  if (m_rectangles.empty())
+    return false;
+  m_lastDelivered = m_rectangles.front();
+  m_windowed = true;
+  return true;
 }
 
 //------------------------------------------------------
@@ -299,46 +956,85 @@ void Optimizer::generateRectangles()
 void Optimizer::greedyMatch()
 {
 //  Pre-conditions
-  assert(m_covering.none());
+  assert(m_covering.empty());
+  PhaseTimer timer(timing(), Statistics::kGreedy);
 
-//  define bitmap to where the strawberries are
-  dynamic_bitset<> unmatchedStrawberries(Global::numColumns * Global::numRows);
-  foreach(const strawberry& s, Global::strawberries) {
-    unmatchedStrawberries.set(Global::numColumns*s.first + s.second);
-  }
-  m_covering.resize(Global::numColumns * Global::numRows);
-  dynamic_bitset<> allStrawberries(unmatchedStrawberries);
+  m_covering.assign(m_field->numRows() + 1, vector<int>(m_field->numColumns() + 1, 0));
+  size_t unmatchedStrawberries = m_field->strawberries().size();
 
   do {
     Rectangle* r = findNextRectangle();
-    m_covering |= r->span();
+    if (!r)
+      break;
+    cover(r);
+#ifdef CHECK_SPANS
+    r->makeSpan(*m_field);
+#endif
 
     //  promote rectangle from candidate to semi-finalist
     m_result.push_back(r);
 
-    unmatchedStrawberries -= m_covering;
-  } while (unmatchedStrawberries.any());
+    // the result set is disjoint
+    unmatchedStrawberries -= r->weight();
+  } while (unmatchedStrawberries > 0 && !interrupted());
   m_rectangles.clear();
+  m_windowed = false;
   m_covering.clear();
 }
 
+//---------------------------------------------------
+// m_rectangles is a priority structure with lazy
+// deletion: a candidate that meets the covering is
+// discarded when it reaches the back of the vector,
+// using an O(1) lookup in the covering's summed-area
+// table rather than its span. When the window runs
+// dry the next one is generated. Only the chosen
+// candidate is made into a Rectangle.
+//---------------------------------------------------
 Rectangle* Optimizer::findNextRectangle()
 {
-  Rectangle* r = m_rectangles.back();
-  // lazy initialization
-  r->makeSpan();
+  for (;;) {
+    if (m_rectangles.empty() && !generateRectangles())
+      break;
+    Candidate c = m_rectangles.back();
+    m_rectangles.pop_back();
+    if (!isCovered(c.topLeftRow(), c.topLeftColumn(), c.bottomRightRow(), c.bottomRightColumn())) {
+      return new(m_arenas[0].malloc())
+             Rectangle(c.topLeftRow(), c.topLeftColumn(),
+                       c.bottomRightRow(), c.bottomRightColumn(), c.weight());
+    }
+    ++m_statistics.rectanglesRejected;
+  }
+  // every uncovered strawberry has a live candidate,
+  // unless generation was interrupted
+  assert(interrupted());
+  return NULL;
+}
 
-  if (m_covering.any()) {
-    dynamic_bitset<> meet;
-    do {
-      r = m_rectangles.back();
-      // lazy initialization
-      r->makeSpan();
-      meet = m_covering & r->span();
-      m_rectangles.pop_back();
-    } while (meet.any() && m_rectangles.size() > 0);
+//---------------------------------------------------
+// Adds the cells of *r to the summed-area table of
+// the covering: entry (i, j) grows by the area of *r
+// above and to the left of cell (i, j).
+//---------------------------------------------------
+void Optimizer::cover(const Rectangle* r)
+{
+  const int M = m_field->numRows();
+  const int N = m_field->numColumns();
+  for (int i = r->topLeftRow() + 1; i <= M; ++i) {
+    int height = min(i - 1, r->bottomRightRow()) - r->topLeftRow() + 1;
+    for (int j = r->topLeftColumn() + 1; j <= N; ++j) {
+      int width = min(j - 1, r->bottomRightColumn()) - r->topLeftColumn() + 1;
+      m_covering[i][j] += height*width;
+    }
   }
-  return r;
+}
+
+bool Optimizer::isCovered(int top, int left, int bottom, int right) const
+{
+  ++bottom;
+  ++right;
+  return m_covering[bottom][right] - m_covering[top][right]
+         - m_covering[bottom][left] + m_covering[top][left] > 0;
 }
 
 //--------------------------------------
@@ -354,25 +1050,137 @@ Rectangle* Optimizer::joinRectangles(const Rectangle* r1, const Rectangle* r2)
   int topLeftColumn = min(r1->topLeftColumn(), r2->topLeftColumn());
   int bottomRightRow = max(r1->bottomRightRow(), r2->bottomRightRow());
   int bottomRightColumn = max(r1->bottomRightColumn(), r2->bottomRightColumn());
-  Rectangle* r =  new(Global::rectanglePool.malloc())
-  Rectangle(topLeftRow, topLeftColumn,
+  return newRectangle(topLeftRow, topLeftColumn, bottomRightRow, bottomRightColumn);
+}
+
+//--------------------------------------
+// Gives the slices of a shade's penumbra,
+// and with join its join, back to the
+// arena of the given worker, except those
+// that a move put in the result set
+//--------------------------------------
+void Optimizer::recycleShade(Shade* shade, bool join, size_t worker)
+{
+  Rectangle *original, *slice;
+  foreach(boost::tie(original, slice), shade->penumbra) {
+    if (!m_result.contains(slice))
+      m_arenas[worker].free(slice);
+  }
+  shade->penumbra.clear();
+  if (join && !m_result.contains(shade->m_join))
+    m_arenas[worker].free(shade->m_join);
+}
+
+//--------------------------------------
+// Creates a rectangle in the arena of
+// the given worker
+//--------------------------------------
+Rectangle* Optimizer::newRectangle(int topLeftRow, int topLeftColumn,
+                                   int bottomRightRow, int bottomRightColumn,
+                                   size_t worker)
+{
+  Rectangle* r = new(m_arenas[worker].malloc())
+  Rectangle(*m_field, topLeftRow, topLeftColumn,
             bottomRightRow, bottomRightColumn);
-  // lazy initialization
-  r->makeSpan();
+#ifdef CHECK_SPANS
+  r->makeSpan(*m_field);
+#endif
   return r;
 }
 
 void Optimizer::assertDisjoint()
 {
-  ListIterator end = m_result.end();
-  for (ListIterator i = m_result.begin(); i != end; ++i)
-    for (ListIterator j = i; ++j != end; /**/)
+  ResultSet::const_iterator end = m_result.end();
+  for (ResultSet::const_iterator i = m_result.begin(); i != end; ++i)
+    for (ResultSet::const_iterator j = i; ++j != end; /**/) {
       assert(!((*i)->intersects(*j)));
+#ifdef CHECK_SPANS
+      assert(!((*i)->spanIntersects(*j)));
+#endif
+    }
+}
+
+//----------------------------------------------------------------
+// Computes the envelope, penumbra and penalty of *shade with
+// respect to the rest of the result set. Returns false if the join
+// slices some rectangle into more than one piece (kIncreasing),
+// in which case the shade is not a candidate move.
+// Slices are allocated from the arena of the given worker, so
+// shades may be evaluated concurrently.
+//----------------------------------------------------------------
+void Optimizer::evaluateEntry(const vector<ShadeEntry*>* entries, size_t i, size_t worker)
+{
+  ShadeEntry* entry = (*entries)[i];
+  entry->admissible = evaluateShade(&entry->shade, worker);
+}
+
+void Optimizer::evaluateEntries(const vector<ShadeEntry*>& entries)
+{
+  m_statistics.shadesEvaluated += entries.size();
+  m_threads->parallelFor(entries.size(),
+                         boost::bind(&Optimizer::evaluateEntry, this, &entries, _1, _2));
+}
+
+//----------------------------------------------------------------
+// Finds the best admissible shade in chunk i of the table
+//----------------------------------------------------------------
+void Optimizer::reduceEntries(const vector<ShadeEntry*>* entries,
+                              vector<BestShade>* best, size_t i, size_t)
+{
+  const size_t chunks = best->size();
+  const size_t begin = i*entries->size()/chunks;
+  const size_t end = (i + 1)*entries->size()/chunks;
+  BestShade& local = (*best)[i];
+  for (size_t k = begin; k < end; ++k) {
+    const ShadeEntry* entry = (*entries)[k];
+    if (!entry->admissible)
+      continue;
+    BestShade candidate;
+    candidate.shade = &entry->shade;
+    size_t p1 = entry->shade.m_r1->slot();
+    size_t p2 = entry->shade.m_r2->slot();
+    candidate.rank = pair<size_t, size_t>(min(p1, p2), max(p1, p2));
+    if (candidate < local)
+      local = candidate;
+  }
+}
+
+bool Optimizer::evaluateShade(Shade* shade, size_t worker)
+{
+  shade->envelope.clear();
+  recycleShade(shade, false, worker);
+
+  // only the rectangles meeting the join can be in its shade
+  vector<Slice> slices;
+  ResultSet::Query query(m_result, shade->m_join, shade->m_r1, shade->m_r2);
+  while (Rectangle* r3 = query.next()) {
+    Slice s(r3);
+    determineIntersectionType(r3, shade->m_join, &s);
+#ifdef CHECK_SPANS
+    assertSliceAgreesWithSpans(*m_field, r3, shade->m_join, s);
+#endif
+    if (kIncreasing == s.intersection)
+      return false;
+    if (kVoid != s.intersection)
+      slices.push_back(s);
+  }
+
+  foreach(const Slice& s, slices) {
+    if (s.intersection == kDecreasing) {
+      shade->envelope.push_back(s.original);
+    } else {
+      shade->penumbra[s.original] =
+        newRectangle(s.topLeftRow, s.topLeftColumn,
+                     s.bottomRightRow, s.bottomRightColumn, worker);
+    }
+  }
+  shade->finalize();
+  return true;
 }
 
 //----------------------------------------------------------------
 // Third and final stage of the optimizer pipeline.
-// localSearch() recursively searches for joins among the rectangles
+// localSearch() iteratively searches for joins among the rectangles
 // in the result set that are globally cost-decreasing
 // and cardinality non-increasing. The search continues
 // while the global cost gradient is negative or we are above
@@ -380,79 +1188,189 @@ void Optimizer::assertDisjoint()
 // negative cost gradients and we are still above m_maxRectangles,
 // the search continues with the least penalizing joins until
 // the covering cardinality constraint is met.
+//
+// In anytime mode, once the time limit or move limit is spent
+// only those least penalizing joins are made, so the search still
+// ends with a covering that meets the constraint.
+//
+// The table of pairwise shades persists across moves. Applying a
+// shade only changes the result set inside its join and its
+// penumbra, so only shades whose join meets that region are
+// re-evaluated; shades of removed rectangles are dropped and
+// shades of the new join and slices are added. Ties are broken
+// by the positions of the pair in the result set, which picks the
+// same move as a from-scratch scan of every pair.
+//
+// During a sweep() the cardinality constraint is 1, and the result
+// set is recorded after every move.
+//
+// The joins and slices of shades that are dropped or re-evaluated
+// go back to the arenas, so the rectangles held follow the size of
+// the table rather than the number of shades ever evaluated.
+//
+// With a tile size T, the table holds only the pairs whose join
+// spans at most T rows and columns, found through the grid index
+// of the result set, so that the table, and the shades each move
+// re-evaluates, grow with the area of the field rather than the
+// square of the number of rectangles. While the constraint is not
+// met and no pair within the span is admissible, the span doubles,
+// until it covers the field.
 //----------------------------------------------------------------
 void Optimizer::localSearch()
 {
-  if (m_result.size() < 2 )
+  if (m_result.size() < 2 || interrupted())
     return;
+  PhaseTimer timer(timing(), Statistics::kLocalSearch);
 
-  list<Shade> shades;
-  ListIterator end = m_result.end();
-  for (ListIterator i = m_result.begin(); i != end; ++i) {
-    for (ListIterator j = i; ++j != end; /**/ ) {
-      Rectangle* r1 = *i;
-      Rectangle* r2 = *j;
-      Rectangle* join = joinRectangles(r1, r2);
-      Shade shade(r1, r2, join);
-      ListIterator k = i;
-      ListIterator m = j;
-      vector<Rectangle*> difference_set;
-
-      foreach(Rectangle* r, iterator_range<ListIterator> (m_result.begin(), k))
-      difference_set.push_back(r);
-      foreach(Rectangle* r, iterator_range<ListIterator> (++k, m))
-      difference_set.push_back(r);
-      foreach(Rectangle* r, iterator_range<ListIterator> (++m, m_result.end()))
-      difference_set.push_back(r);
-
-      vector<Slice> slices;
-      foreach(Rectangle* r3, difference_set) {
-        Slice s(r3);
-        determineIntersectionType(r3, join, &s);
-        if (kVoid != s.intersection)
-          slices.push_back(s);
-      }
+  const size_t fieldSpan = max(m_field->numRows(), m_field->numColumns());
+  size_t span = m_tileSize < fieldSpan ? m_tileSize : 0;
+  list<ShadeEntry> table;
+  vector<ShadeEntry*> pending;
+  vector<Rectangle*> near;
+  foreach(Rectangle* r1, m_result) {
+    partners(r1, span, &near);
+    foreach(Rectangle* r2, near) {
+      // each pair once
+      if (r1->slot() > r2->slot())
+        continue;
+      table.push_back(ShadeEntry(Shade(r1, r2, joinRectangles(r1, r2))));
+      pending.push_back(&table.back());
+    }
+  }
+  evaluateEntries(pending);
 
-      if (slices.empty()) {
-        // join did not intersect any rectangle in result set
-        shades.push_back(shade);
-      } else {
-        sort(slices.begin(), slices.end());
-        if (slices.back().intersection != kIncreasing) {
-          foreach(Slice s, slices) {
-            if (s.intersection == kDecreasing) {
-              shade.envelope.push_back(s.original);
-            } else {
-              Rectangle* r =
-                new(Global::rectanglePool.malloc())
-              Rectangle(s.topLeftRow, s.topLeftColumn,
-                        s.bottomRightRow, s.bottomRightColumn);
-              r->makeSpan();
-              shade.penumbra[s.original] = r;
-            }
-          }
-          shades.push_back(shade);
+  vector<ShadeEntry*> entries;
+  vector<BestShade> chunks(m_threads->size());
+  vector<Rectangle*> touched;
+  vector<Rectangle*> added;
+  size_t moves = 0;
+  while (!interrupted()) {
+    // best shade by a parallel min-reduction over the table
+    entries.clear();
+    foreach(ShadeEntry& entry, table) entries.push_back(&entry);
+    fill(chunks.begin(), chunks.end(), BestShade());
+    m_threads->parallelFor(chunks.size(),
+                           boost::bind(&Optimizer::reduceEntries, this,
+                                       &entries, &chunks, _1, _2));
+    const Shade* best = std::min_element(chunks.begin(), chunks.end())->shade;
+
+    // no admissible pair within the span: widen it
+    if (!best && span != 0 && m_result.size() > m_maxRectangles) {
+      const size_t narrower = span;
+      span = 2*span < fieldSpan ? 2*span : 0;
+      pending.clear();
+      foreach(Rectangle* r1, m_result) {
+        partners(r1, span, &near);
+        foreach(Rectangle* r2, near) {
+          if (r1->slot() > r2->slot() || joinFits(r1, r2, narrower))
+            continue;
+          table.push_back(ShadeEntry(Shade(r1, r2, joinRectangles(r1, r2))));
+          pending.push_back(&table.back());
         }
-      }  // end case of non-empty slices
+      }
+      evaluateEntries(pending);
+      continue;
     }
-  }  // end iteration over 2-combinations in result set
-
-  shades.sort();
-  const Shade& best = shades.front();
-  if (best.penalty() <= 0 || m_result.size() > m_maxRectangles) {
-    m_result.remove(best.m_r1);
-    m_result.remove(best.m_r2);
-    m_result.push_back(best.m_join);
-    foreach(Rectangle* r, best.envelope) {
+
+    // out of budget, only the joins the cardinality constraint forces are made
+    const bool improving = best && best->penalty() <= 0 && !budgetExhausted(moves);
+    if (!best || !(improving || m_result.size() > m_maxRectangles))
+      break;
+    ++moves;
+
+    //  the table is updated below, so apply a copy
+    const Shade move(*best);
+    ++m_statistics.moves;
+    m_result.remove(move.m_r1);
+    m_result.remove(move.m_r2);
+    m_result.push_back(move.m_join);
+    foreach(Rectangle* r, move.envelope) {
       m_result.remove(r);
     }
 
     Rectangle *original, *slice;
-    foreach(boost::tie(original, slice), best.penumbra) {
-      replace(m_result.begin(), m_result.end(), original, slice);
+    foreach(boost::tie(original, slice), move.penumbra) {
+      m_result.replace(original, slice);
     }
+    // slots keep their order, so compacting leaves the ranks of pairs intact
+    if (m_result.tombstones() > m_result.size())
+      m_result.compact();
+    if (m_sweep)
+      recordSweep();
 
-    localSearch();
+    if (m_result.size() < 2)
+      break;
+
+    touched.assign(1, move.m_join);
+    added.assign(1, move.m_join);
+    foreach(boost::tie(original, slice), move.penumbra) {
+      touched.push_back(original);
+      added.push_back(slice);
+    }
+
+    pending.clear();
+    list<ShadeEntry>::iterator it = table.begin();
+    while (it != table.end()) {
+      Shade& shade = it->shade;
+      // shades of rectangles the move removed or sliced
+      if (!m_result.contains(shade.m_r1) || !m_result.contains(shade.m_r2)) {
+        recycleShade(&shade, true, 0);
+        it = table.erase(it);
+        continue;
+      }
+      foreach(Rectangle* r, touched) {
+        if (shade.m_join->intersects(r)) {
+          pending.push_back(&*it);
+          break;
+        }
+      }
+      ++it;
+    }
+
+    for (size_t k = 0; k < added.size(); ++k) {
+      Rectangle* r1 = added[k];
+      partners(r1, span, &near);
+      foreach(Rectangle* r2, near) {
+        // each pair of added rectangles once
+        if (std::find(added.begin(), added.begin() + k + 1, r2) != added.begin() + k + 1)
+          continue;
+        table.push_back(ShadeEntry(Shade(r1, r2, joinRectangles(r1, r2))));
+        pending.push_back(&table.back());
+      }
+    }
+    evaluateEntries(pending);
+  }
+  foreach(ShadeEntry& entry, table) recycleShade(&entry.shade, true, 0);
+}
+
+//---------------------------------------------------------
+// Stores in *partners the rectangles of the result set,
+// other than r, whose join with r fits span (see joinFits()).
+// With a span only the region of the grid index they can
+// lie in is scanned.
+//---------------------------------------------------------
+void Optimizer::partners(const Rectangle* r, size_t span, vector<Rectangle*>* partners) const
+{
+  partners->clear();
+  if (span == 0) {
+    foreach(Rectangle* other, m_result) {
+      if (other != r)
+        partners->push_back(other);
+    }
+    return;
+  }
+  const int S = int(min(span, size_t(max(m_field->numRows(), m_field->numColumns()))));
+  const int topLeftRow = max(0, r->bottomRightRow() - S + 1);
+  const int topLeftColumn = max(0, r->bottomRightColumn() - S + 1);
+  const int bottomRightRow = min(int(m_field->numRows()) - 1, r->topLeftRow() + S - 1);
+  const int bottomRightColumn = min(int(m_field->numColumns()) - 1, r->topLeftColumn() + S - 1);
+  if (topLeftRow > bottomRightRow || topLeftColumn > bottomRightColumn)
+    return;
+  const Rectangle region(topLeftRow, topLeftColumn, bottomRightRow, bottomRightColumn, 0);
+  ResultSet::Query query(m_result, &region, r, NULL);
+  while (Rectangle* other = query.next()) {
+    if (joinFits(r, other, span))
+      partners->push_back(other);
   }
 }
 
@@ -464,78 +1382,26 @@ void Optimizer::localSearch()
 //--------------------------------------------------------
 void Optimizer::computeConvexHull()
 {
-//  define bitmap to where the strawberries are
-  dynamic_bitset<> strawberries(Global::numColumns * Global::numRows);
-  foreach(strawberry s, Global::strawberries) {
-    strawberries.set(Global::numColumns*s.first + s.second);
+  // strawberries are in row-major order
+  const vector<strawberry>& strawberries = m_field->strawberries();
+  assert(!strawberries.empty());
+  int topLeftColumn = strawberries.front().second;
+  int bottomRightColumn = topLeftColumn;
+  foreach(const strawberry& s, strawberries) {
+    topLeftColumn = min(topLeftColumn, s.second);
+    bottomRightColumn = max(bottomRightColumn, s.second);
   }
 
-  set<size_t> rows;
-  set<size_t> columns;
-  size_t col, row;
-  size_t pos = strawberries.find_first();
-  do {
-    col = pos % Global::numColumns;
-    row = (pos - col)/Global::numColumns;
-    rows.insert(row);
-    columns.insert(col);
-    pos = strawberries.find_next(pos);
-  } while (pos != dynamic_bitset<>::npos);
-
-  size_t topLeftRow = *(rows.begin());
-  size_t topLeftColumn = *(columns.begin());
-  size_t bottomRightRow = *(rows.rbegin());
-  size_t bottomRightColumn = *(columns.rbegin());
-
-  Rectangle* r = new(Global::rectanglePool.malloc())
-  Rectangle(topLeftRow, topLeftColumn, bottomRightRow, bottomRightColumn);
-  r->makeSpan();
-  m_result.push_back(r);
+  m_result.push_back(newRectangle(strawberries.front().first, topLeftColumn,
+                                  strawberries.back().first, bottomRightColumn));
 }
 
 void Optimizer::label()
 {
   m_result.sort(Rectangle::better);
   m_result.reverse();
-  int index = 0;
-  foreach(Rectangle* r, m_result) {
-    index < 52 ? r->setLabel(alphabet[index]) : r->setLabel('0');
-    ++index;
-  }
-}
-
-void Optimizer::output()
-{
-  char output[Global::numRows][Global::numColumns];
-  fill(&output[0][0], &output[0][0] + sizeof(output), '.');
-  ofstream outFile(Global::outFile.c_str(), ios_base::out | ios_base::app);
-  size_t row, col;
-  row = col = 0;
-  int cost = 0;
-  foreach(Rectangle* r, m_result) {
-    cost += r->cost();
-    size_t pos = r->span().find_first();
-    while (pos != dynamic_bitset<>::npos) {
-      col = pos % Global::numColumns;
-      row = (pos - col)/Global::numColumns;
-      output[row][col] = r->label();
-      pos = r->span().find_next(pos);
-    }
-  }
-  outFile << "Cardinality:" << m_result.size() << "\n"
-          << "Cost:" << cost << "\n";
-  for (size_t j = 0; j < Global::numColumns; ++j) {
-    outFile << "=";
-  }
-  outFile << "\n";
-  for (row = 0; row < Global::numRows; ++row) {
-    for (col = 0; col < Global::numColumns; ++col) {
-      outFile << output[row][col];
-    }
-    outFile << "\n";
-  }
-  outFile << "\n";
-  outFile.close();
+  size_t index = 0;
+  foreach(Rectangle* r, m_result) r->setLabel(index++);
 }
 
 #undef foreach
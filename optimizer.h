@@ -9,12 +9,22 @@
 #define OPTIMIZER_H
 
 #include <stdint.h>
+#include <ostream>
+#include <string>
 #include <vector>
-#include <list>
+#include <boost/atomic.hpp>
+#include <boost/ptr_container/ptr_vector.hpp>
+#include <boost/scoped_ptr.hpp>
 #include <boost/utility.hpp>
-#include <boost/dynamic_bitset.hpp>
+#include "arena.h"
+#include "covering.h"
+#include "resultset.h"
+#include "statistics.h"
+#include "threadpool.h"
 
+class Field;
 class Rectangle;
+struct Shade;
 
 class Optimizer : boost::noncopyable
 {
@@ -23,11 +33,109 @@ public:
   ~Optimizer();
 
   //--------------------------------
-  // Executes the optimizer.
-  // Writes output to the file pathname
-  // contained in Global::outFile
+  // Executes the optimizer on an indexed
+  // field, writes the labeled covering
+  // to out and returns its cost
   //--------------------------------
-  int run();
+  long long run(const Field& field, std::ostream& out);
+
+  //--------------------------------
+  // As above, appending the covering
+  // to *block (see Covering::render()),
+  // unless block is NULL, and, if result
+  // is given, storing it in *result
+  //--------------------------------
+  long long run(const Field& field, std::string* block, Covering* result = NULL);
+
+  //--------------------------------
+  // Executes the optimizer on an indexed
+  // field and stores the labeled covering
+  // in *covering. Returns false, leaving
+  // *covering untouched, if the run was
+  // interrupted.
+  //--------------------------------
+  bool solve(const Field& field, Covering* covering);
+
+  //--------------------------------
+  // Cardinality sweep: for every k from
+  // 1 to the cardinality constraint,
+  // stores in (*coverings)[k - 1] the
+  // best covering with at most k
+  // rectangles seen along one local
+  // search trajectory. Generation and
+  // greedy matching run once, and the
+  // least penalizing joins are carried
+  // on down to a single rectangle. The
+  // k = 1 covering is the convex hull
+  // (see computeConvexHull()). Fields
+  // are not split into regions. Returns
+  // false if the run was interrupted.
+  //--------------------------------
+  bool sweep(const Field& field, std::vector<Covering>* coverings);
+
+  //--------------------------------
+  // Stepwise runs for the multi-start
+  // search (see multistart.h). begin()
+  // runs the pipeline on the field and
+  // keeps the result, perturb() tries
+  // one perturb-and-reoptimize move on
+  // it and end() stores the best covering
+  // found in *covering, if given, and
+  // releases the run. Fields are not split
+  // into regions. begin() returns false
+  // if the run was interrupted.
+  //--------------------------------
+  bool begin(const Field& field);
+
+  //--------------------------------
+  // Splits a rectangle of the best
+  // covering in two, at a random cut,
+  // and searches again from there. The
+  // result is kept if it is cheaper and
+  // meets the cardinality constraint;
+  // returns true if so.
+  //--------------------------------
+  bool perturb();
+
+  inline long long cost() const {
+    return m_bestCost;
+  }
+  void end(Covering* covering);
+
+  //--------------------------------
+  // Seeds the candidate order of later
+  // runs: ties are broken at random and,
+  // with noise > 0, each weight-to-cost
+  // ratio is scaled by a random factor
+  // in [1 - noise, 1 + noise]. The same
+  // seed gives the same runs. Seed 0
+  // restores the deterministic order.
+  //--------------------------------
+  void setSeed(uint64_t seed, double noise);
+
+  //---------------------------------
+  // Anytime mode: once a run has spent
+  // seconds (0 = no limit) or applied
+  // maxMoves local search moves (0 = no
+  // limit), the local search stops making
+  // improving moves and only performs the
+  // least penalizing joins still needed to
+  // meet the cardinality constraint. The
+  // covering returned is valid and the
+  // best one found so far. Generation and
+  // greedy matching always complete.
+  //---------------------------------
+  void setTimeLimit(double seconds);
+  void setMaxMoves(size_t maxMoves);
+
+  //---------------------------------
+  // Abandons subsequent runs as soon as
+  // *cancelled is set or, for a non-zero
+  // deadline, the monotonic clock passes
+  // it (see timer.h). NULL disables
+  // cancellation.
+  //---------------------------------
+  void setInterrupt(const boost::atomic<bool>* cancelled, double deadline);
 
   //---------------------------------
   // Sets the cardinality constraint
@@ -36,22 +144,237 @@ public:
   //---------------------------------
   void setMaxRectangles(int maxRectangles);
 
+  //---------------------------------
+  // Bounds the number of candidate
+  // rectangles held in memory at once.
+  // The best candidates are kept and the
+  // rest are regenerated on demand as the
+  // greedy phase consumes them.
+  // 0 keeps every candidate.
+  //---------------------------------
+  void setCandidateCapacity(size_t capacity);
+
+  //---------------------------------
+  // Large-field mode: candidates span
+  // at most tileSize rows and columns,
+  // so that generating them costs time
+  // in proportion to the area of the
+  // field instead of its number of
+  // rectangles, and the local search
+  // only joins pairs within that span
+  // until it must widen it to meet the
+  // cardinality constraint (see
+  // localSearch()). 0 sets no bound.
+  //---------------------------------
+  void setTileSize(size_t tileSize);
+
+  //---------------------------------
+  // Number of threads used to evaluate
+  // shades during local search
+  //---------------------------------
+  void setThreads(size_t threads);
+
+  //---------------------------------
+  // Splits each field into independent
+  // regions (see regions.h) and optimizes
+  // them separately, on the local search
+  // threads. If their coverings together
+  // exceed the cardinality constraint the
+  // whole field is optimized instead.
+  //---------------------------------
+  void setDecomposition(bool decompose);
+
+  //---------------------------------
+  // Enables the phase clocks of the
+  // statistics kept for each run
+  //---------------------------------
+  void setStatistics(bool enabled);
+
+  //---------------------------------
+  // Statistics of the last solve(),
+  // including the regions of the field
+  //---------------------------------
+  inline const Statistics& statistics() const {
+    return m_statistics;
+  }
+  static const size_t kDefaultCandidateCapacity = 1 << 16;
+
 private:
-  void generateRectangles();
+  //---------------------------------
+  // Candidate rectangle awaiting the greedy
+  // phase. Candidates are totally ordered by
+  // weight-to-cost ratio, then weight, then
+  // corners, so that a window of the best
+  // candidates can be regenerated exactly.
+  //
+  // A candidate is a 128-bit key, compared as
+  // two integers. The first holds, from the top,
+  // 39 bits of weight-to-cost ratio, 20 bits of
+  // weight and 5 tie-break bits (0 unless seeded,
+  // see setSeed()); the second the four corners,
+  // 16 bits each, stored complemented so that
+  // nearer corners rank higher. The ratio bits
+  // are floor(weight*2^39/cost), which is exact
+  // for costs up to 741455: two distinct ratios
+  // of such costs differ by more than 2^-39.
+  // Larger rectangles still rank in a fixed
+  // total order. The heap and sort of the window
+  // compare plain integers, and the greedy scan
+  // decodes corners with shifts.
+  //---------------------------------
+  struct Candidate {
+    uint64_t key;
+    uint64_t corners;
+
+    static Candidate make(int topLeftRow, int topLeftColumn,
+                          int bottomRightRow, int bottomRightColumn, size_t weight);
+
+    inline int topLeftRow() const {
+      return kCornerMask - int((corners >> 48) & kCornerMask);
+    }
+    inline int topLeftColumn() const {
+      return kCornerMask - int((corners >> 32) & kCornerMask);
+    }
+    inline int bottomRightRow() const {
+      return kCornerMask - int((corners >> 16) & kCornerMask);
+    }
+    inline int bottomRightColumn() const {
+      return kCornerMask - int(corners & kCornerMask);
+    }
+    inline size_t weight() const {
+      return size_t(key >> kWeightShift) & kWeightMask;
+    }
+    // true if *this ranks strictly below other
+    inline bool operator<(const Candidate& other) const {
+      return key < other.key || (key == other.key && corners < other.corners);
+    }
+    inline bool operator>(const Candidate& other) const {
+      return other < *this;
+    }
+
+    static const int kCornerMask = 65535;
+    static const int kWeightShift = 5;
+    static const size_t kWeightMask = (1 << 20) - 1;
+    static const int kRatioShift = 25;
+    static const uint64_t kRatioMask = (uint64_t(1) << 39) - 1;
+    static const uint64_t kTieBreakMask = 31;
+  };
+
+  bool solveField(const Field& field, Covering* covering);
+  bool solveRegions(const Field& field, const std::vector<Box>& regions,
+                    Covering* covering);
+  void solveRegion(const std::vector<Field>*, std::vector<Covering>*,
+                   std::vector<char>*, std::vector<Statistics>*,
+                   size_t i, size_t worker);
+  Statistics* timing();
+
+  bool generateRectangles();
   void greedyMatch();
   void localSearch();
   void computeConvexHull();
+  void recordSweep();
+  void randomize(Candidate* c) const;
+  uint64_t random();
+  Box tighten(int topLeftRow, int topLeftColumn,
+              int bottomRightRow, int bottomRightColumn) const;
+  bool split(Rectangle* r);
+  void keepBest();
+  void restoreBest();
   void label();
-  void output();
+  bool interrupted();
+  bool budgetExhausted(size_t moves) const;
   void assertDisjoint();
   void reset();
   Rectangle* findNextRectangle();
+  void cover(const Rectangle*);
+  bool isCovered(int topLeftRow, int topLeftColumn,
+                 int bottomRightRow, int bottomRightColumn) const;
   Rectangle* joinRectangles(const Rectangle*, const Rectangle*);
+  bool evaluateShade(Shade*, size_t worker);
+  void partners(const Rectangle* r, size_t span, std::vector<Rectangle*>* partners) const;
+  void recycleShade(Shade*, bool join, size_t worker);
+
+  struct ShadeEntry;
+  struct BestShade;
+  void evaluateEntries(const std::vector<ShadeEntry*>&);
+  void evaluateEntry(const std::vector<ShadeEntry*>*, size_t i, size_t worker);
+  void reduceEntries(const std::vector<ShadeEntry*>*,
+                     std::vector<BestShade>*, size_t i, size_t worker);
 
+  Rectangle* newRectangle(int topLeftRow, int topLeftColumn,
+                          int bottomRightRow, int bottomRightColumn,
+                          size_t worker = 0);
+
+  const Field* m_field;
   size_t m_maxRectangles;
-  std::vector<Rectangle* > m_rectangles;
-  std::list<Rectangle*> m_result;
-  boost::dynamic_bitset<> m_covering;
+
+  const boost::atomic<bool>* m_cancelled;
+  double m_deadline;
+  bool m_interrupted;
+
+  double m_timeLimit;
+  size_t m_maxMoves;
+  double m_stopAt;  // monotonic clock; 0 without a time limit
+
+  //-----------------------------------
+  // Best covering of each cardinality
+  // during a sweep(), NULL otherwise
+  //-----------------------------------
+  std::vector<Covering>* m_sweep;
+
+  //-----------------------------------
+  // Seeded candidate order, the state of
+  // the random numbers drawn by perturb()
+  // and the best covering of a run begun
+  // by begin()
+  //-----------------------------------
+  uint64_t m_seed;
+  double m_noise;
+  uint64_t m_random;
+  std::vector<Box> m_best;
+  long long m_bestCost;
+
+  //-----------------------------------
+  // Worker threads for local search, each
+  // with its own rectangle arena. All
+  // rectangles of a run are created in
+  // these arenas and released together at
+  // reset, keeping their blocks for the
+  // next run; the calling thread uses
+  // arena 0.
+  //-----------------------------------
+  boost::scoped_ptr<ThreadPool> m_threads;
+  boost::ptr_vector<Arena> m_arenas;
+
+  Statistics m_statistics;
+  bool m_timing;
+
+  size_t m_candidateCapacity;
+  size_t m_tileSize;
+
+  //-----------------------------------
+  // Optimizers of the regions of a field,
+  // one per local search thread
+  //-----------------------------------
+  bool m_decompose;
+  boost::ptr_vector<Optimizer> m_regionOptimizers;
+
+  //-----------------------------------
+  // Window of candidates in ascending order,
+  // and the worst candidate handed out so far;
+  // the next window is drawn from those
+  // strictly below it.
+  //-----------------------------------
+  std::vector<Candidate> m_rectangles;
+  Candidate m_lastDelivered;
+  bool m_windowed;
+  ResultSet m_result;
+
+  //-----------------------------------
+  // Summed-area table of the cells covered
+  // by the greedy result set so far
+  //-----------------------------------
+  std::vector<std::vector<int> > m_covering;
 };
 
 #endif
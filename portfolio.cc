@@ -0,0 +1,244 @@
+// -----------------------------------------------------------
+//  File: portfolio.cc
+//  Author: Gregory Rehbein
+//
+//  Copyright (C) 2012 Gregory Rehbein <gmrehbein@gmail.com>
+// -----------------------------------------------------------
+
+// Self
+#include "portfolio.h"
+
+// C
+#include <cassert>
+#include <cstdio>
+
+// C++
+#include <algorithm>
+
+// Boost
+#include <boost/bind/bind.hpp>
+#include <boost/foreach.hpp>
+
+#include "field.h"
+#include "symmetry.h"
+#include "timer.h"
+
+using std::vector;
+using boost::placeholders::_1;
+using boost::placeholders::_2;
+
+#define foreach BOOST_FOREACH
+
+Portfolio::Portfolio()
+  : m_threads(kNumSymmetries), m_field(NULL), m_maxRectangles(0),
+    m_deadline(0), m_lowerBound(0), m_cancelled(false),
+    m_coverings(kNumSymmetries), m_completed(kNumSymmetries, 0)
+{
+  for (size_t g = 0; g < kNumSymmetries; ++g)
+    m_optimizers.push_back(new Optimizer);
+}
+
+Portfolio::~Portfolio()
+{
+}
+
+void Portfolio::setMaxRectangles(int m)
+{
+  m_maxRectangles = m;
+}
+
+void Portfolio::setCandidateCapacity(size_t capacity)
+{
+  foreach(Optimizer& optimizer, m_optimizers) optimizer.setCandidateCapacity(capacity);
+}
+
+void Portfolio::setTileSize(size_t tileSize)
+{
+  foreach(Optimizer& optimizer, m_optimizers) optimizer.setTileSize(tileSize);
+}
+
+void Portfolio::setThreads(size_t threads)
+{
+  foreach(Optimizer& optimizer, m_optimizers) optimizer.setThreads(threads);
+}
+
+void Portfolio::setDecomposition(bool decompose)
+{
+  foreach(Optimizer& optimizer, m_optimizers) optimizer.setDecomposition(decompose);
+}
+
+void Portfolio::setStatistics(bool enabled)
+{
+  foreach(Optimizer& optimizer, m_optimizers) optimizer.setStatistics(enabled);
+}
+
+void Portfolio::setTimeLimit(double seconds)
+{
+  foreach(Optimizer& optimizer, m_optimizers) optimizer.setTimeLimit(seconds);
+}
+
+void Portfolio::setMaxMoves(size_t maxMoves)
+{
+  foreach(Optimizer& optimizer, m_optimizers) optimizer.setMaxMoves(maxMoves);
+}
+
+void Portfolio::setDeadline(double seconds)
+{
+  m_deadline = seconds;
+}
+
+long long Portfolio::run(const Field& field, std::ostream& out)
+{
+  std::string block;
+  long long cost = run(field, &block);
+  out.write(block.data(), block.size());
+  return cost;
+}
+
+long long Portfolio::run(const Field& field, std::string* block, Covering* result)
+{
+  double start_time = wallTime();
+  Covering covering;
+  solve(field, &covering);
+  printf("optimized %zu X %zu field of %zu strawberries over %d symmetries in %.6f seconds\n",
+         field.numRows(), field.numColumns(), field.strawberries().size(),
+         m_maxRectangles > 1 ? int(kNumSymmetries) : 1,
+         wallTime() - start_time);
+  if (block)
+    covering.render(block, field.numRows(), field.numColumns());
+  if (result)
+    *result = covering;
+  m_maxRectangles = 0;
+  return covering.cost();
+}
+
+//--------------------------------------------------------
+// Every rectangle costs 10 plus its area, and the areas of
+// a covering sum to at least the number of strawberries,
+// so no covering beats a single rectangle of strawberries.
+//
+// The hull computed under a cardinality constraint of 1 is
+// invariant under D4, so only the identity is run.
+//--------------------------------------------------------
+bool Portfolio::solve(const Field& field, Covering* covering)
+{
+  m_field = &field;
+  m_lowerBound = 10 + field.strawberries().size();
+  m_cancelled = false;
+  std::fill(m_completed.begin(), m_completed.end(), 0);
+
+  const size_t symmetries = m_maxRectangles > 1 ? size_t(kNumSymmetries) : 1;
+  const double deadline = m_deadline > 0 ? wallTime() + m_deadline : 0;
+  for (size_t g = 0; g < symmetries; ++g)
+    m_optimizers[g].setInterrupt(&m_cancelled, g == kIdentity ? 0 : deadline);
+  m_threads.parallelFor(symmetries, boost::bind(&Portfolio::solveSymmetry, this, _1, _2));
+
+  m_statistics.clear();
+  for (size_t g = 0; g < symmetries; ++g)
+    m_statistics += m_optimizers[g].statistics();
+
+  // cheapest completed covering; ties go to the lowest symmetry
+  int best = -1;
+  for (size_t g = 0; g < symmetries; ++g) {
+    if (m_completed[g] && (best < 0 || m_coverings[g].cost() < m_coverings[best].cost()))
+      best = g;
+  }
+  assert(best >= 0);
+  *covering = m_coverings[best];
+  m_field = NULL;
+  return true;
+}
+
+//--------------------------------------------------------
+// No covering cancels a sweep, since every cardinality
+// must be reached; the deadline still applies.
+//--------------------------------------------------------
+bool Portfolio::sweep(const Field& field, vector<Covering>* coverings)
+{
+  m_field = &field;
+  m_cancelled = false;
+  std::fill(m_completed.begin(), m_completed.end(), 0);
+  m_sweeps.resize(kNumSymmetries);
+
+  const size_t symmetries = m_maxRectangles > 1 ? size_t(kNumSymmetries) : 1;
+  const double deadline = m_deadline > 0 ? wallTime() + m_deadline : 0;
+  for (size_t g = 0; g < symmetries; ++g)
+    m_optimizers[g].setInterrupt(&m_cancelled, g == kIdentity ? 0 : deadline);
+  m_threads.parallelFor(symmetries, boost::bind(&Portfolio::sweepSymmetry, this, _1, _2));
+
+  m_statistics.clear();
+  for (size_t g = 0; g < symmetries; ++g)
+    m_statistics += m_optimizers[g].statistics();
+
+  // cheapest completed covering of each cardinality; ties go to the lowest symmetry
+  assert(m_completed[kIdentity]);
+  *coverings = m_sweeps[kIdentity];
+  for (size_t g = 1; g < symmetries; ++g) {
+    if (!m_completed[g])
+      continue;
+    for (size_t k = 0; k < coverings->size(); ++k) {
+      if (m_sweeps[g][k].cost() < (*coverings)[k].cost())
+        (*coverings)[k] = m_sweeps[g][k];
+    }
+  }
+  m_field = NULL;
+  m_maxRectangles = 0;
+  return true;
+}
+
+void Portfolio::sweepSymmetry(size_t symmetry, size_t)
+{
+  const Symmetry g = Symmetry(symmetry);
+  Field image;
+  const Field* field = m_field;
+  if (g != kIdentity) {
+    transformField(g, *m_field, &image);
+    field = &image;
+  }
+
+  Optimizer& optimizer = m_optimizers[g];
+  optimizer.setMaxRectangles(m_maxRectangles);
+  vector<Covering> coverings;
+  if (!optimizer.sweep(*field, &coverings))
+    return;
+
+  // map the coverings back to the field
+  vector<Covering>& result = m_sweeps[g];
+  result.assign(coverings.size(), Covering());
+  for (size_t k = 0; k < coverings.size(); ++k) {
+    foreach(const Box& box, coverings[k].boxes()) {
+      result[k].add(transformBox(inverse(g), field->numRows(), field->numColumns(), box));
+    }
+    result[k].order(*m_field);
+  }
+  m_completed[g] = 1;
+}
+
+void Portfolio::solveSymmetry(size_t symmetry, size_t)
+{
+  const Symmetry g = Symmetry(symmetry);
+  Field image;
+  const Field* field = m_field;
+  if (g != kIdentity) {
+    transformField(g, *m_field, &image);
+    field = &image;
+  }
+
+  Optimizer& optimizer = m_optimizers[g];
+  optimizer.setMaxRectangles(m_maxRectangles);
+  Covering covering;
+  if (!optimizer.solve(*field, &covering))
+    return;
+  if (covering.cost() <= m_lowerBound)
+    m_cancelled = true;
+
+  // map the covering back to the field
+  Covering& result = m_coverings[g];
+  result = Covering();
+  foreach(const Box& box, covering.boxes()) {
+    result.add(transformBox(inverse(g), field->numRows(), field->numColumns(), box));
+  }
+  m_completed[g] = 1;
+}
+
+#undef foreach
@@ -0,0 +1,119 @@
+// -----------------------------------------------------------
+//  File: portfolio.h
+//  Author: Gregory Rehbein
+//
+//  Portfolio class declaration. Removes the sort bias of the
+//  greedy phase by running the optimizer pipeline on each of
+//  the 8 images of a field under the dihedral group D4, one
+//  thread per symmetry, and mapping the cheapest covering
+//  back under its group inverse.
+//
+//  A run whose cost meets the lower bound of the field cancels
+//  the others, and symmetries still running at the deadline
+//  are abandoned. The identity image ignores the deadline, so
+//  the portfolio never does worse than a single Optimizer.
+//
+//  Copyright (C) 2012 Gregory Rehbein <gmrehbein@gmail.com>
+// -----------------------------------------------------------
+
+#ifndef PORTFOLIO_H
+#define PORTFOLIO_H
+
+#include <ostream>
+#include <string>
+#include <vector>
+#include <boost/atomic.hpp>
+#include <boost/ptr_container/ptr_vector.hpp>
+#include <boost/utility.hpp>
+#include "covering.h"
+#include "optimizer.h"
+#include "statistics.h"
+#include "threadpool.h"
+
+class Field;
+
+class Portfolio : boost::noncopyable
+{
+public:
+  Portfolio();
+  ~Portfolio();
+
+  //--------------------------------
+  // Same contract as Optimizer::run()
+  //--------------------------------
+  long long run(const Field& field, std::ostream& out);
+  long long run(const Field& field, std::string* block, Covering* result = NULL);
+
+  //--------------------------------
+  // Stores the best covering of the
+  // field over all symmetries in
+  // *covering. The identity always
+  // completes, so this returns true.
+  //--------------------------------
+  bool solve(const Field& field, Covering* covering);
+
+  //--------------------------------
+  // Optimizer::sweep() of every
+  // symmetry, keeping the cheapest
+  // covering of each cardinality
+  //--------------------------------
+  bool sweep(const Field& field, std::vector<Covering>* coverings);
+
+  void setMaxRectangles(int maxRectangles);
+  void setCandidateCapacity(size_t capacity);
+  void setTileSize(size_t tileSize);
+  void setThreads(size_t threads);
+  void setDecomposition(bool decompose);
+  void setStatistics(bool enabled);
+  void setTimeLimit(double seconds);
+  void setMaxMoves(size_t maxMoves);
+
+  //---------------------------------
+  // Statistics of the last solve(),
+  // summed over the symmetries run
+  //---------------------------------
+  inline const Statistics& statistics() const {
+    return m_statistics;
+  }
+
+  //---------------------------------
+  // Wall-clock seconds after which the
+  // symmetries other than the identity
+  // are abandoned. 0 waits for all.
+  //---------------------------------
+  void setDeadline(double seconds);
+
+private:
+  void solveSymmetry(size_t symmetry, size_t worker);
+  void sweepSymmetry(size_t symmetry, size_t worker);
+
+  ThreadPool m_threads;
+  boost::ptr_vector<Optimizer> m_optimizers;
+
+  const Field* m_field;
+  int m_maxRectangles;
+  double m_deadline;
+
+  //-----------------------------------
+  // Cost no covering of the field can
+  // beat, and the flag raised once a
+  // symmetry reaches it
+  //-----------------------------------
+  long long m_lowerBound;
+  boost::atomic<bool> m_cancelled;
+
+  //-----------------------------------
+  // Coverings mapped back to the field,
+  // indexed by symmetry, and whether each
+  // run completed
+  //-----------------------------------
+  std::vector<Covering> m_coverings;
+  std::vector<char> m_completed;
+
+  // coverings of each cardinality, by symmetry, during a sweep()
+  std::vector<std::vector<Covering> > m_sweeps;
+
+  Statistics m_statistics;
+};
+
+#endif // PORTFOLIO_H
@@ -0,0 +1,131 @@
+// -----------------------------------------------------------
+//  File: reader.cc
+//  Author: Gregory Rehbein
+//
+//  Copyright (C) 2012 Gregory Rehbein <gmrehbein@gmail.com>
+// -----------------------------------------------------------
+
+// Self
+#include "reader.h"
+
+// C
+#include <cctype>
+#include <cerrno>
+#include <cstring>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include "field.h"
+
+FieldReader::FieldReader(const std::string& path)
+  : m_begin(NULL), m_end(NULL), m_position(NULL), m_map(NULL), m_mapLength(0), m_fd(-1)
+{
+  int fd = open(path.c_str(), O_RDONLY);
+  if (fd < 0)
+    return;
+
+  struct stat st;
+  if (fstat(fd, &st) == 0 && S_ISREG(st.st_mode) && st.st_size > 0) {
+    void* map = mmap(NULL, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    if (map != MAP_FAILED) {
+      madvise(map, st.st_size, MADV_SEQUENTIAL);
+      m_map = map;
+      m_mapLength = st.st_size;
+      m_begin = static_cast<const char*>(map);
+      m_end = m_begin + m_mapLength;
+    }
+  }
+
+  if (!m_map) {
+    // pipes and the like: read the whole input
+    char chunk[1 << 16];
+    ssize_t n;
+    while ((n = read(fd, chunk, sizeof(chunk))) > 0)
+      m_buffer.insert(m_buffer.end(), chunk, chunk + n);
+    if (!m_buffer.empty()) {
+      m_begin = &m_buffer[0];
+      m_end = m_begin + m_buffer.size();
+    }
+  }
+  close(fd);
+  m_position = m_begin;
+}
+
+FieldReader::FieldReader(int fd)
+  : m_begin(NULL), m_end(NULL), m_position(NULL), m_map(NULL), m_mapLength(0), m_fd(fd)
+{
+}
+
+FieldReader::~FieldReader()
+{
+  if (m_map)
+    munmap(m_map, m_mapLength);
+}
+
+bool FieldReader::next(Field* field, int* maxRectangles)
+{
+  field->clear();
+  while (m_position < m_end || refill()) {
+    const char* line = m_position;
+    const char* eol = static_cast<const char*>(memchr(line, '\n', m_end - line));
+    if (!eol && refill())
+      continue;  // the rest of the line is still to come
+    if (!eol)
+      eol = m_end;
+    m_position = eol < m_end ? eol + 1 : m_end;
+
+    size_t length = eol - line;
+    if (length && line[length - 1] == '\r')
+      --length;
+
+    if (length) {
+      if (isdigit(static_cast<unsigned char>(line[0]))) {
+        // the mapping need not be terminated, so no strtol()
+        int value = 0;
+        for (size_t n = 0; n < length && isdigit(static_cast<unsigned char>(line[n])); ++n)
+          value = 10*value + (line[n] - '0');
+        *maxRectangles = value;
+      } else
+        field->addRow(line, length);
+    } else if (!field->empty()) {
+      // a blank line ends the field
+      field->index();
+      return true;
+    }
+  }
+  // handle the last field
+  if (!field->empty()) {
+    field->index();
+    return true;
+  }
+  return false;
+}
+
+//--------------------------------------------
+// Streaming: drops the lines already parsed and
+// blocks until more input arrives. Returns false
+// at the end of the input, or always for a file.
+//--------------------------------------------
+bool FieldReader::refill()
+{
+  if (m_fd < 0)
+    return false;
+  m_buffer.erase(m_buffer.begin(), m_buffer.begin() + (m_position - m_begin));
+
+  char chunk[1 << 16];
+  ssize_t n;
+  do
+    n = read(m_fd, chunk, sizeof(chunk));
+  while (n < 0 && errno == EINTR);
+  if (n > 0)
+    m_buffer.insert(m_buffer.end(), chunk, chunk + n);
+  else
+    m_fd = -1;
+
+  m_begin = m_buffer.empty() ? NULL : &m_buffer[0];
+  m_end = m_begin + m_buffer.size();
+  m_position = m_begin;
+  return n > 0;
+}
@@ -0,0 +1,71 @@
+// -----------------------------------------------------------
+//  File: reader.h
+//  Author: Gregory Rehbein
+//
+//  FieldReader class declaration. Parses the fields of an input
+//  file in place: the file is memory-mapped (or, if it cannot
+//  be mapped, read in one piece) and scanned line by line with
+//  memchr, and each row is packed straight into the Field.
+//  Lines may be of any length.
+//
+//  A streaming reader instead reads a descriptor, such as stdin
+//  or a socket, as the fields arrive: next() returns each field
+//  as soon as the blank line that ends it has been read, so a
+//  client can wait for the covering of one field before sending
+//  the next.
+//
+//  The input is a sequence of fields separated by blank lines.
+//  A line starting with a digit sets the cardinality constraint
+//  of the field; every other non-blank line is a row of the
+//  field, in which '@' marks a strawberry.
+//
+//  Copyright (C) 2012 Gregory Rehbein <gmrehbein@gmail.com>
+// -----------------------------------------------------------
+
+#ifndef READER_H
+#define READER_H
+
+#include <cstddef>
+#include <string>
+#include <vector>
+#include <boost/utility.hpp>
+
+class Field;
+
+class FieldReader : boost::noncopyable
+{
+public:
+  //--------------------------------
+  // Opens the file; a file that cannot
+  // be opened reads as empty
+  //--------------------------------
+  explicit FieldReader(const std::string& path);
+
+  //--------------------------------
+  // Streaming reader of an open
+  // descriptor, which it does not close
+  //--------------------------------
+  explicit FieldReader(int fd);
+  ~FieldReader();
+
+  //--------------------------------
+  // Reads the next field into *field,
+  // which is cleared first, and indexes
+  // it. Returns false if no field is left.
+  //--------------------------------
+  bool next(Field* field, int* maxRectangles);
+
+private:
+  bool refill();
+
+  const char* m_begin;
+  const char* m_end;
+  const char* m_position;
+
+  void* m_map;
+  size_t m_mapLength;
+  std::vector<char> m_buffer;  // used if the file cannot be mapped
+  int m_fd;                    // streamed descriptor until its end, -1 otherwise
+};
+
+#endif // READER_H
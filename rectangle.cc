@@ -7,20 +7,23 @@
 
 // self
 #include "rectangle.h"
-#include "global.h"
+#include "field.h"
 #include <cassert>
 #include <utility>
 
 using std::make_pair;
 
-Rectangle::Rectangle(int topLeftRow, int topLeftColumn,
+Rectangle::Rectangle(const Field& field, int topLeftRow, int topLeftColumn,
                      int bottomRightRow, int bottomRightColumn)
   :m_topLeft(make_pair(topLeftRow, topLeftColumn)),
    m_bottomRight(make_pair(bottomRightRow, bottomRightColumn)),
-   m_area(((bottomRightColumn - topLeftColumn) + 1)*((bottomRightRow - topLeftRow) + 1)),
-   m_weight(Global::weightOfRectangle(topLeftRow, topLeftColumn, bottomRightRow, bottomRightColumn)),
-   m_spun(false)
+   m_area(size_t(bottomRightColumn - topLeftColumn + 1)*size_t(bottomRightRow - topLeftRow + 1)),
+   m_weight(field.weightOfRectangle(topLeftRow, topLeftColumn, bottomRightRow, bottomRightColumn)),
+   m_slot(0), m_label(0)
 {
+#ifdef CHECK_SPANS
+  m_spun = false;
+#endif
   assert(m_area > 0);
   m_weightToCostRatio = double(m_weight)/(10 + m_area);
 }
@@ -29,9 +32,12 @@ Rectangle::Rectangle(int topLeftRow, int topLeftColumn,
                      int bottomRightRow, int bottomRightColumn,int weight)
   :m_topLeft(make_pair(topLeftRow, topLeftColumn)),
    m_bottomRight(make_pair(bottomRightRow, bottomRightColumn)),
-   m_area(((bottomRightColumn - topLeftColumn) + 1)*((bottomRightRow - topLeftRow) + 1)),
-   m_weight(weight), m_spun(false)
+   m_area(size_t(bottomRightColumn - topLeftColumn + 1)*size_t(bottomRightRow - topLeftRow + 1)),
+   m_weight(weight), m_slot(0), m_label(0)
 {
+#ifdef CHECK_SPANS
+  m_spun = false;
+#endif
   assert(m_area > 0);
   m_weightToCostRatio = double(m_weight)/(10 + m_area);
 }
@@ -40,16 +46,58 @@ Rectangle::~Rectangle()
 {
 }
 
-void Rectangle::makeSpan()
+#ifdef CHECK_SPANS
+void Rectangle::makeSpan(const Field& field)
 {
-  if (!m_spun) {
-    m_span.resize(Global::numRows*Global::numColumns);
+  const size_t numColumns = field.numColumns();
+  // larger fields are not cross-checked
+  if (!m_spun && field.numRows()*numColumns <= Span::kCapacity) {
+    m_span.reset();
+    const size_t width = m_bottomRight.second - m_topLeft.second + 1;
     for (int i = m_topLeft.first; i <= m_bottomRight.first; ++i)
-      for (int j = m_topLeft.second; j <= m_bottomRight.second; ++j)
-        m_span.set(i*Global::numColumns + j);
+      m_span.set(i*numColumns + m_topLeft.second, width);
     m_spun = true;
   }
 }
+#endif
+
+bool Rectangle::differenceIsRectangle(const Rectangle* other,
+                                      int* topLeftRow, int* topLeftColumn,
+                                      int* bottomRightRow, int* bottomRightColumn) const
+{
+  assert(intersects(other) && !isSubsetOf(other));
+
+  int top = m_topLeft.first;
+  int left = m_topLeft.second;
+  int bottom = m_bottomRight.first;
+  int right = m_bottomRight.second;
+
+  // *other must span this rectangle completely in one
+  // dimension and cut off one end of it in the other
+  if (other->m_topLeft.second <= left && right <= other->m_bottomRight.second) {
+    if (other->m_topLeft.first <= top)
+      top = other->m_bottomRight.first + 1;
+    else if (bottom <= other->m_bottomRight.first)
+      bottom = other->m_topLeft.first - 1;
+    else
+      return false;
+  } else if (other->m_topLeft.first <= top && bottom <= other->m_bottomRight.first) {
+    if (other->m_topLeft.second <= left)
+      left = other->m_bottomRight.second + 1;
+    else if (right <= other->m_bottomRight.second)
+      right = other->m_topLeft.second - 1;
+    else
+      return false;
+  } else {
+    return false;
+  }
+
+  *topLeftRow = top;
+  *topLeftColumn = left;
+  *bottomRightRow = bottom;
+  *bottomRightColumn = right;
+  return true;
+}
 
 bool Rectangle::better(const Rectangle* r1, const Rectangle* r2)
 {
@@ -8,8 +8,13 @@
 #ifndef RECTANGLE_H
 #define RECTANGLE_H
 
+#include <cstddef>
 #include <utility>
-#include <boost/dynamic_bitset.hpp>
+#ifdef CHECK_SPANS
+#include "span.h"
+#endif
+
+class Field;
 
 class Rectangle
 {
@@ -19,13 +24,16 @@ class Rectangle
   size_t m_weight;
   double m_weightToCostRatio;
 
-  char m_label;
-  boost::dynamic_bitset<> m_span;
+  size_t m_slot;   // index in the optimizer's result set
+  size_t m_label;  // index in label order
+#ifdef CHECK_SPANS
   bool m_spun;
+  Span m_span;
+#endif
 
 public:
 
-  Rectangle(int topLeftRow, int topLeftColumn,
+  Rectangle(const Field& field, int topLeftRow, int topLeftColumn,
             int bottomRightRow, int bottomRightColumn);
   Rectangle(int topLeftRow, int topLeftColumn,
             int bottomRightRow, int bottomRightColumn, int weight);
@@ -37,7 +45,7 @@ public:
   inline size_t cost() const {
     return 10 + m_area;
   }
-  inline char label() const {
+  inline size_t label() const {
     return m_label;
   }
   inline size_t weight() const {
@@ -58,27 +66,71 @@ public:
   inline int bottomRightColumn() const {
     return m_bottomRight.second;
   }
+
+  //-------------------------------------------
+  // Coordinate-only predicates: answered in O(1)
+  // from the corners, without the span.
+  //-------------------------------------------
   inline bool intersects(const Rectangle* other) const {
-    return m_span.intersects(other->m_span);
+    return m_topLeft.first <= other->m_bottomRight.first
+           && other->m_topLeft.first <= m_bottomRight.first
+           && m_topLeft.second <= other->m_bottomRight.second
+           && other->m_topLeft.second <= m_bottomRight.second;
   }
   inline bool isSubsetOf(const Rectangle* other) const {
+    return other->m_topLeft.first <= m_topLeft.first
+           && m_bottomRight.first <= other->m_bottomRight.first
+           && other->m_topLeft.second <= m_topLeft.second
+           && m_bottomRight.second <= other->m_bottomRight.second;
+  }
+
+  //-------------------------------------------
+  // For a rectangle that intersects but is not a
+  // subset of *other, returns true iff
+  // *this \ *other is a single rectangle, in which
+  // case its corners are written to the out-parameters.
+  //-------------------------------------------
+  bool differenceIsRectangle(const Rectangle* other,
+                             int* topLeftRow, int* topLeftColumn,
+                             int* bottomRightRow, int* bottomRightColumn) const;
+
+#ifdef CHECK_SPANS
+  //-------------------------------------------
+  // Bitmap counterparts of the predicates above.
+  // Both spans must have been made. Used by debug
+  // builds to cross-check the coordinate predicates
+  // on fields that fit a Span.
+  //-------------------------------------------
+  inline bool spanIntersects(const Rectangle* other) const {
+    return m_span.intersects(other->m_span);
+  }
+  inline bool spanIsSubsetOf(const Rectangle* other) const {
     return m_span.is_subset_of(other->m_span);
   }
-  inline const boost::dynamic_bitset<>& span() const {
+  inline const Span& span() const {
     return m_span;
   }
+#endif
   inline bool operator< (const Rectangle& other) const {
     return m_weightToCostRatio < other.m_weightToCostRatio;
   }
-  inline void setLabel(char c) {
-    m_label = c;
+  inline void setLabel(size_t label) {
+    m_label = label;
+  }
+  inline size_t slot() const {
+    return m_slot;
+  }
+  inline void setSlot(size_t slot) {
+    m_slot = slot;
   }
 
+#ifdef CHECK_SPANS
   //-------------------------------------------
   // Turn on all bits contained within the
   // rectangle's span
   //-------------------------------------------
-  void makeSpan();
+  void makeSpan(const Field& field);
+#endif
 
   //--------------------------------------------------
   // Convenience function operating on type Rectangle*.
@@ -0,0 +1,145 @@
+// -----------------------------------------------------------
+//  File: regions.cc
+//  Author: Gregory Rehbein
+//
+//  Copyright (C) 2012 Gregory Rehbein <gmrehbein@gmail.com>
+// -----------------------------------------------------------
+
+// Self
+#include "regions.h"
+
+// C++
+#include <algorithm>
+#include <utility>
+
+// Boost
+#include <boost/foreach.hpp>
+
+#include "field.h"
+
+using std::min;
+using std::max;
+using std::pair;
+using std::vector;
+
+#define foreach BOOST_FOREACH
+
+namespace
+{
+typedef pair<int, int> Cell;
+
+//------------------------------------------------
+// Width of a band of empty rows or columns that
+// no greenhouse of an optimal covering crosses: a
+// greenhouse crossing it holds at least kBand
+// empty cells of it, and splitting the greenhouse
+// at the band saves them for the $10 of a second
+// greenhouse
+//------------------------------------------------
+const int kBand = 11;
+
+//------------------------------------------------
+// Splits part, in row-major order, at the first
+// band of at least kBand empty rows, or failing
+// that columns, across its extent. Returns false
+// if there is none.
+//------------------------------------------------
+bool cut(const vector<Cell>& part, vector<Cell>* first, vector<Cell>* second)
+{
+  first->clear();
+  second->clear();
+  for (size_t k = 1; k < part.size(); ++k) {
+    if (part[k].first - part[k - 1].first > kBand) {
+      first->assign(part.begin(), part.begin() + k);
+      second->assign(part.begin() + k, part.end());
+      return true;
+    }
+  }
+
+  vector<int> columns;
+  foreach(const Cell& s, part) columns.push_back(s.second);
+  std::sort(columns.begin(), columns.end());
+  for (size_t k = 1; k < columns.size(); ++k) {
+    if (columns[k] - columns[k - 1] > kBand) {
+      foreach(const Cell& s, part) {
+        if (s.second < columns[k])
+          first->push_back(s);
+        else
+          second->push_back(s);
+      }
+      return true;
+    }
+  }
+  return false;
+}
+
+//------------------------------------------------
+// Bounding box of a region and its first
+// strawberry, for the row-major order of regions
+//------------------------------------------------
+struct Region {
+  Cell first;
+  Box box;
+  bool operator<(const Region& other) const {
+    return first < other.first;
+  }
+};
+}  // end anon namespace
+
+//--------------------------------------------------------
+// Recursive guillotine split: a part of the strawberries
+// is cut at any band of at least kBand empty rows or
+// columns across its extent, and each side is cut again
+// until no band is left. Since no greenhouse of an optimal
+// covering crosses a band, the optimal coverings of the
+// regions together are an optimal covering of the field
+// whenever they meet the cardinality constraint.
+//--------------------------------------------------------
+void findRegions(const Field& field, vector<Box>* regions)
+{
+  regions->clear();
+  if (field.strawberries().empty())
+    return;
+
+  vector<Region> found;
+  vector<vector<Cell> > parts(1, field.strawberries());
+  vector<Cell> first;
+  vector<Cell> second;
+  while (!parts.empty()) {
+    vector<Cell> part;
+    part.swap(parts.back());
+    parts.pop_back();
+    if (cut(part, &first, &second)) {
+      parts.push_back(first);
+      parts.push_back(second);
+      continue;
+    }
+    Region region;
+    region.first = part.front();
+    region.box.topLeftRow = part.front().first;
+    region.box.bottomRightRow = part.back().first;
+    region.box.topLeftColumn = part.front().second;
+    region.box.bottomRightColumn = part.front().second;
+    foreach(const Cell& s, part) {
+      region.box.topLeftColumn = min(region.box.topLeftColumn, s.second);
+      region.box.bottomRightColumn = max(region.box.bottomRightColumn, s.second);
+    }
+    found.push_back(region);
+  }
+  std::sort(found.begin(), found.end());
+  foreach(const Region& region, found) regions->push_back(region.box);
+}
+
+void cropField(const Field& field, const Box& box, Field* region)
+{
+  region->clear();
+  vector<int> row(box.bottomRightColumn - box.topLeftColumn + 1);
+  for (int i = box.topLeftRow; i <= box.bottomRightRow; ++i) {
+    for (int j = box.topLeftColumn; j <= box.bottomRightColumn; ++j)
+      row[j - box.topLeftColumn] = field.at(i, j);
+    region->addRow(row);
+  }
+  region->index();
+}
+
+#undef foreach
@@ -0,0 +1,41 @@
+// -----------------------------------------------------------
+//  File: regions.h
+//  Author: Gregory Rehbein
+//
+//  Decomposition of a strawberry field into independent
+//  regions by a recursive guillotine split: the strawberries
+//  are cut at every band of at least 11 empty rows or columns
+//  across the extent of the part being cut. A greenhouse
+//  crossing such a band holds at least 11 empty cells of it,
+//  so splitting it there always saves more than the $10 of
+//  the second greenhouse, and merging across regions can
+//  never pay off: optimal coverings of the regions that meet
+//  the cardinality constraint together make an optimal
+//  covering of the field. Each region is optimized on its own
+//  bounding box, and the boxes of distinct regions are
+//  disjoint, so the coverings of the regions never overlap.
+//
+//  Copyright (C) 2012 Gregory Rehbein <gmrehbein@gmail.com>
+// -----------------------------------------------------------
+
+#ifndef REGIONS_H
+#define REGIONS_H
+
+#include <vector>
+#include "covering.h"
+
+class Field;
+
+//--------------------------------------------
+// Bounding boxes of the regions of an indexed
+// field, in row-major order of their first
+// strawberry
+//--------------------------------------------
+void findRegions(const Field& field, std::vector<Box>* regions);
+
+//--------------------------------------------
+// Indexed field of the cells of box
+//--------------------------------------------
+void cropField(const Field& field, const Box& box, Field* region);
+
+#endif // REGIONS_H
@@ -0,0 +1,302 @@
+// -----------------------------------------------------------
+//  File: resultset.h
+//  Author: Gregory Rehbein
+//
+//  ResultSet class declaration. The optimizer's result set as
+//  a vector of slots in insertion order. Each rectangle holds
+//  the index of its slot, so removing or replacing a rectangle
+//  is O(1): a removed rectangle leaves a NULL tombstone and a
+//  replacement takes over the slot of the original. The slots
+//  of the others never move, so the slot order is the order
+//  in which rectangles entered the set, as it was for the list
+//  this replaces. compact() drops the tombstones, keeping that
+//  order.
+//
+//  Iteration skips tombstones.
+//
+//  The set also keeps a spatial index: a uniform grid of
+//  8 X 8 cell bins over the field, each listing the rectangles
+//  that overlap it, updated as rectangles are added, removed
+//  and replaced. A Query visits only the rectangles that meet
+//  a given region, each once, skipping two excluded ones;
+//  this is how the rest of the set is scanned for each pair
+//  without building a difference set, at a cost that depends
+//  on the size of the region rather than of the set.
+//
+//  Copyright (C) 2012 Gregory Rehbein <gmrehbein@gmail.com>
+// -----------------------------------------------------------
+
+#ifndef RESULTSET_H
+#define RESULTSET_H
+
+#include <algorithm>
+#include <cassert>
+#include <cstddef>
+#include <iterator>
+#include <vector>
+#include "rectangle.h"
+
+class ResultSet
+{
+public:
+  static const int kBinShift = 3;
+  static const int kBinSize = 1 << kBinShift;
+
+  //--------------------------------
+  // Forward iterator over the live
+  // rectangles in slot order
+  //--------------------------------
+  class const_iterator
+  {
+  public:
+    typedef std::forward_iterator_tag iterator_category;
+    typedef Rectangle* value_type;
+    typedef std::ptrdiff_t difference_type;
+    typedef Rectangle* const* pointer;
+    typedef Rectangle* const& reference;
+
+    const_iterator() : m_slot(NULL), m_end(NULL) {}
+
+    inline reference operator*() const {
+      return *m_slot;
+    }
+    inline const_iterator& operator++() {
+      ++m_slot;
+      skip();
+      return *this;
+    }
+    inline const_iterator operator++(int) {
+      const_iterator it(*this);
+      ++*this;
+      return it;
+    }
+    inline bool operator==(const const_iterator& other) const {
+      return m_slot == other.m_slot;
+    }
+    inline bool operator!=(const const_iterator& other) const {
+      return m_slot != other.m_slot;
+    }
+
+  private:
+    friend class ResultSet;
+    const_iterator(Rectangle* const* slot, Rectangle* const* end)
+      : m_slot(slot), m_end(end) {
+      skip();
+    }
+    inline void skip() {
+      while (m_slot != m_end && *m_slot == NULL)
+        ++m_slot;
+    }
+
+    Rectangle* const* m_slot;
+    Rectangle* const* m_end;
+  };
+  typedef const_iterator iterator;
+
+  //--------------------------------
+  // Rectangles of the set meeting a
+  // region, other than two excluded
+  // ones, in no particular order:
+  //   Query q(set, region, r1, r2);
+  //   while (Rectangle* r = q.next()) ...
+  // The set must not change while a
+  // Query is open.
+  //--------------------------------
+  class Query
+  {
+  public:
+    Query(const ResultSet& set, const Rectangle* region,
+          const Rectangle* exclude1, const Rectangle* exclude2)
+      : m_set(set), m_region(region), m_exclude1(exclude1), m_exclude2(exclude2),
+        m_firstBinRow(region->topLeftRow() >> kBinShift),
+        m_firstBinColumn(region->topLeftColumn() >> kBinShift),
+        m_lastBinRow(region->bottomRightRow() >> kBinShift),
+        m_lastBinColumn(region->bottomRightColumn() >> kBinShift),
+        m_binRow(m_firstBinRow), m_binColumn(m_firstBinColumn), m_index(0) {}
+
+    Rectangle* next() {
+      while (m_binRow <= m_lastBinRow) {
+        const std::vector<Rectangle*>& bin = m_set.bin(m_binRow, m_binColumn);
+        while (m_index < bin.size()) {
+          Rectangle* r = bin[m_index++];
+          if (r == m_exclude1 || r == m_exclude2 || !r->intersects(m_region))
+            continue;
+          // report r only in the first bin that both r and the region meet
+          int row = std::max(r->topLeftRow(), m_region->topLeftRow()) >> kBinShift;
+          int column = std::max(r->topLeftColumn(), m_region->topLeftColumn()) >> kBinShift;
+          if (row == m_binRow && column == m_binColumn)
+            return r;
+        }
+        m_index = 0;
+        if (++m_binColumn > m_lastBinColumn) {
+          m_binColumn = m_firstBinColumn;
+          ++m_binRow;
+        }
+      }
+      return NULL;
+    }
+
+  private:
+    const ResultSet& m_set;
+    const Rectangle* m_region;
+    const Rectangle* m_exclude1;
+    const Rectangle* m_exclude2;
+    int m_firstBinRow;
+    int m_firstBinColumn;
+    int m_lastBinRow;
+    int m_lastBinColumn;
+    int m_binRow;
+    int m_binColumn;
+    size_t m_index;
+  };
+
+  ResultSet() : m_size(0), m_binColumns(0) {}
+
+  //--------------------------------
+  // Sizes the spatial index for a
+  // field; the set must be empty
+  //--------------------------------
+  void setBounds(size_t rows, size_t columns) {
+    assert(empty());
+    m_binColumns = (columns + kBinSize - 1) >> kBinShift;
+    m_bins.resize(((rows + kBinSize - 1) >> kBinShift)*m_binColumns);
+  }
+
+  inline size_t size() const {
+    return m_size;
+  }
+  inline bool empty() const {
+    return m_size == 0;
+  }
+
+  //--------------------------------
+  // Number of slots, tombstones
+  // included, and the rectangle in
+  // a slot (NULL for a tombstone)
+  //--------------------------------
+  inline size_t slots() const {
+    return m_slots.size();
+  }
+  inline Rectangle* operator[](size_t slot) const {
+    return m_slots[slot];
+  }
+
+  inline const_iterator begin() const {
+    return const_iterator(data(), data() + m_slots.size());
+  }
+  inline const_iterator end() const {
+    return const_iterator(data() + m_slots.size(), data() + m_slots.size());
+  }
+
+  //--------------------------------
+  // true iff *r is in the set; O(1)
+  //--------------------------------
+  inline bool contains(const Rectangle* r) const {
+    return r->slot() < m_slots.size() && m_slots[r->slot()] == r;
+  }
+
+  inline void push_back(Rectangle* r) {
+    r->setSlot(m_slots.size());
+    m_slots.push_back(r);
+    ++m_size;
+    index(r);
+  }
+  inline void remove(Rectangle* r) {
+    assert(m_slots[r->slot()] == r);
+    m_slots[r->slot()] = NULL;
+    --m_size;
+    unindex(r);
+  }
+  inline void replace(Rectangle* original, Rectangle* r) {
+    assert(m_slots[original->slot()] == original);
+    r->setSlot(original->slot());
+    m_slots[r->slot()] = r;
+    unindex(original);
+    index(r);
+  }
+
+  //--------------------------------
+  // Drops the tombstones and renumbers
+  // the slots, keeping their order
+  //--------------------------------
+  void compact() {
+    size_t n = 0;
+    for (size_t i = 0; i < m_slots.size(); ++i) {
+      if (Rectangle* r = m_slots[i]) {
+        r->setSlot(n);
+        m_slots[n++] = r;
+      }
+    }
+    m_slots.resize(n);
+  }
+
+  inline size_t tombstones() const {
+    return m_slots.size() - m_size;
+  }
+
+  //--------------------------------
+  // Empties the set, keeping the
+  // capacity of the slots
+  //--------------------------------
+  inline void clear() {
+    m_slots.clear();
+    m_size = 0;
+    for (size_t i = 0; i < m_bins.size(); ++i)
+      m_bins[i].clear();
+  }
+
+
+  //--------------------------------
+  // Stable sort and reversal of the
+  // set, as with std::list
+  //--------------------------------
+  template <class Compare>
+  void sort(Compare less) {
+    compact();
+    std::stable_sort(m_slots.begin(), m_slots.end(), less);
+    renumber();
+  }
+  void reverse() {
+    compact();
+    std::reverse(m_slots.begin(), m_slots.end());
+    renumber();
+  }
+
+private:
+  inline const std::vector<Rectangle*>& bin(int row, int column) const {
+    return m_bins[row*m_binColumns + column];
+  }
+
+  void index(Rectangle* r) {
+    for (int i = r->topLeftRow() >> kBinShift; i <= r->bottomRightRow() >> kBinShift; ++i)
+      for (int j = r->topLeftColumn() >> kBinShift; j <= r->bottomRightColumn() >> kBinShift; ++j)
+        m_bins[i*m_binColumns + j].push_back(r);
+  }
+  void unindex(Rectangle* r) {
+    for (int i = r->topLeftRow() >> kBinShift; i <= r->bottomRightRow() >> kBinShift; ++i)
+      for (int j = r->topLeftColumn() >> kBinShift; j <= r->bottomRightColumn() >> kBinShift; ++j) {
+        std::vector<Rectangle*>& bin = m_bins[i*m_binColumns + j];
+        std::vector<Rectangle*>::iterator it = std::find(bin.begin(), bin.end(), r);
+        assert(it != bin.end());
+        *it = bin.back();
+        bin.pop_back();
+      }
+  }
+
+  void renumber() {
+    for (size_t i = 0; i < m_slots.size(); ++i)
+      m_slots[i]->setSlot(i);
+  }
+  inline Rectangle* const* data() const {
+    return m_slots.empty() ? NULL : &m_slots[0];
+  }
+
+  std::vector<Rectangle*> m_slots;
+  size_t m_size;
+
+  // spatial index: bins of kBinSize X kBinSize cells, row-major
+  size_t m_binColumns;
+  std::vector<std::vector<Rectangle*> > m_bins;
+};
+
+#endif // RESULTSET_H
@@ -0,0 +1,76 @@
+// -----------------------------------------------------------
+//  File: service.cc
+//  Author: Gregory Rehbein
+//
+//  Copyright (C) 2012 Gregory Rehbein <gmrehbein@gmail.com>
+// -----------------------------------------------------------
+
+// Self
+#include "service.h"
+
+// C
+#include <cerrno>
+#include <cstring>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+ServiceSocket::ServiceSocket(const std::string& path)
+  : m_fd(-1), m_path(path)
+{
+  sockaddr_un address;
+  std::memset(&address, 0, sizeof(address));
+  address.sun_family = AF_UNIX;
+  if (path.empty() || path.size() >= sizeof(address.sun_path))
+    return;
+  std::memcpy(address.sun_path, path.c_str(), path.size());
+
+  int fd = socket(AF_UNIX, SOCK_STREAM, 0);
+  if (fd < 0)
+    return;
+  unlink(path.c_str());
+  if (bind(fd, reinterpret_cast<const sockaddr*>(&address), sizeof(address)) < 0
+      || listen(fd, SOMAXCONN) < 0) {
+    close(fd);
+    return;
+  }
+  m_fd = fd;
+}
+
+ServiceSocket::~ServiceSocket()
+{
+  if (m_fd >= 0) {
+    close(m_fd);
+    unlink(m_path.c_str());
+  }
+}
+
+//--------------------------------------------------------
+// A connection that fails before it is accepted, or a
+// shortage of descriptors or memory, is not a failure of
+// the socket. Shortages are retried after a pause, giving
+// the connections being served time to close.
+//--------------------------------------------------------
+int ServiceSocket::accept()
+{
+  for (;;) {
+    int fd = ::accept(m_fd, NULL, NULL);
+    if (fd >= 0)
+      return fd;
+    switch (errno) {
+    case EINTR:
+    case ECONNABORTED:
+    case EPROTO:
+    case EAGAIN:
+      break;
+    case EMFILE:
+    case ENFILE:
+    case ENOBUFS:
+    case ENOMEM:
+      usleep(kRetryPause);
+      break;
+    default:
+      return -1;
+    }
+  }
+}
@@ -0,0 +1,57 @@
+// -----------------------------------------------------------
+//  File: service.h
+//  Author: Gregory Rehbein
+//
+//  ServiceSocket class declaration. The listening Unix domain
+//  socket of the long-running service mode (--socket). Each
+//  connection carries a stream of fields in the input format
+//  and receives their coverings, in the output format, as they
+//  are done; connections are served one after another by the
+//  same warm solver.
+//
+//  Copyright (C) 2012 Gregory Rehbein <gmrehbein@gmail.com>
+// -----------------------------------------------------------
+
+#ifndef SERVICE_H
+#define SERVICE_H
+
+#include <string>
+#include <boost/utility.hpp>
+
+class ServiceSocket : boost::noncopyable
+{
+public:
+  //--------------------------------
+  // Binds and listens at path, replacing
+  // a stale socket left there; see
+  // listening()
+  //--------------------------------
+  explicit ServiceSocket(const std::string& path);
+
+  //--------------------------------
+  // Closes the socket and removes it
+  // from the file system
+  //--------------------------------
+  ~ServiceSocket();
+
+  inline bool listening() const {
+    return m_fd >= 0;
+  }
+
+  //--------------------------------
+  // Waits for the next connection and
+  // returns its descriptor, retrying
+  // transient errors. Returns -1, with
+  // errno set, if the socket fails.
+  //--------------------------------
+  int accept();
+
+private:
+  // microseconds between retries when out of descriptors or memory
+  static const unsigned kRetryPause = 100000;
+
+  int m_fd;
+  std::string m_path;
+};
+
+#endif // SERVICE_H
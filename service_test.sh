@@ -0,0 +1,58 @@
+#!/bin/sh
+# -----------------------------------------------------------
+#  File: service_test.sh
+#  Author: Gregory Rehbein
+#
+#  Service mode test run by 'make check'. Streams a field
+#  without strawberries followed by an ordinary one through
+#  --serve and checks that both coverings come back and the
+#  service exits cleanly, in the text and the binary format.
+#
+#  Copyright (C) 2012 Gregory Rehbein <gmrehbein@gmail.com>
+# -----------------------------------------------------------
+
+FIELDS='3
+....
+....
+
+2
+.@..
+..@.
+'
+
+EXPECTED='Cardinality:0
+Cost:0
+====
+....
+....
+
+Cardinality:1
+Cost:14
+====
+.AA.
+.AA.
+
+Total Cost: 14'
+
+status=0
+
+actual=$(printf '%s' "$FIELDS" | ./strawberryfields --serve 2>/dev/null)
+if [ $? -ne 0 ] || [ "$actual" != "$EXPECTED" ]; then
+  echo "FAIL: --serve on an empty field followed by a normal one"
+  printf '%s\n' "$actual"
+  status=1
+fi
+
+rm -f service_test.bin service_test.txt
+printf '%s' "$FIELDS" | ./strawberryfields --serve --binary > service_test.bin 2>/dev/null &&
+  ./strawberryfields --convert service_test.bin -o service_test.txt > /dev/null &&
+  actual=$(cat service_test.txt)
+if [ $? -ne 0 ] || [ "$actual" != "$EXPECTED" ]; then
+  echo "FAIL: --serve --binary on an empty field followed by a normal one"
+  printf '%s\n' "$actual"
+  status=1
+fi
+rm -f service_test.bin service_test.txt
+
+[ $status -eq 0 ] && echo "service test passed"
+exit $status
@@ -21,6 +21,7 @@
 #define foreach BOOST_FOREACH
 
 Shade::Shade(Rectangle* r1, Rectangle* r2, Rectangle* join)
+  : m_penalty(0)
 {
   assert(r1 != NULL);
   assert(r2 != NULL);
@@ -40,10 +41,10 @@ Shade::~Shade()
 // its penumbra is cheaper to include in the Optimizer
 // result set than its constituent components.
 //--------------------------------------------------
-int Shade::penalty() const
+void Shade::finalize()
 {
-  int envelopeCost = 0;
-  int penumbraCost = 0;
+  long long envelopeCost = 0;
+  long long penumbraCost = 0;
   foreach(Rectangle* r, envelope) {
     assert(r != NULL);
     envelopeCost += r->cost();
@@ -52,21 +53,7 @@ int Shade::penalty() const
   foreach(boost::tie(original, slice), penumbra) {
     penumbraCost += original->area() - slice->area();
   }
-  int penalty = m_join->cost() - (m_r1->cost() + m_r2->cost() + envelopeCost + penumbraCost);
-  return penalty;
-}
-
-//----------------------------------------------
-// Ordinal function for the Shade class. If
-// two Shades have the same penalty, choose
-// the Shade that encompasses less rectangles
-// in its envelope since that leaves more choices
-// for the optimizer's localSearch() to test
-//----------------------------------------------
-bool Shade::operator< (const Shade &other) const
-{
-  return penalty() == other.penalty() ?
-         envelope.size() < other.envelope.size() : penalty() < other.penalty();
+  m_penalty = (long long)m_join->cost() - ((long long)(m_r1->cost() + m_r2->cost()) + envelopeCost + penumbraCost);
 }
 
 #undef foreach
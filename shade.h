@@ -45,8 +45,29 @@ struct Shade {
   Shade(Rectangle* r1, Rectangle* r2, Rectangle* join);
   ~Shade();
 
-  int penalty() const;
-  bool operator< (const Shade &other) const;
+  //-----------------------------------
+  // Computes and stores the penalty once
+  // the envelope and penumbra are complete.
+  //-----------------------------------
+  void finalize();
+
+  inline long long penalty() const {
+    return m_penalty;
+  }
+  //----------------------------------------------
+  // Ordinal function for the Shade class. If
+  // two Shades have the same penalty, choose
+  // the Shade that encompasses less rectangles
+  // in its envelope since that leaves more choices
+  // for the optimizer's localSearch() to test
+  //----------------------------------------------
+  inline bool operator< (const Shade &other) const {
+    return m_penalty == other.m_penalty ?
+           envelope.size() < other.envelope.size() : m_penalty < other.m_penalty;
+  }
+
+private:
+  long long m_penalty;
 };
 
 #endif
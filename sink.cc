@@ -0,0 +1,97 @@
+// -----------------------------------------------------------
+//  File: sink.cc
+//  Author: Gregory Rehbein
+//
+//  Copyright (C) 2012 Gregory Rehbein <gmrehbein@gmail.com>
+// -----------------------------------------------------------
+
+// Self
+#include "sink.h"
+
+// Boost
+#include <boost/bind/bind.hpp>
+
+namespace
+{
+const size_t kBufferSize = 1 << 20;
+}  // end anon namespace
+
+OutputSink::OutputSink(const std::string& path, bool async)
+  : m_file(std::fopen(path.c_str(), "a")), m_buffer(kBufferSize), m_flush(false),
+    m_stop(false)
+{
+  if (m_file)
+    std::setvbuf(m_file, &m_buffer[0], _IOFBF, m_buffer.size());
+  if (async)
+    m_writer.reset(new boost::thread(boost::bind(&OutputSink::writerLoop, this)));
+}
+
+OutputSink::OutputSink(int fd)
+  : m_file(fd >= 0 ? fdopen(fd, "w") : NULL), m_buffer(kBufferSize), m_flush(true),
+    m_stop(false)
+{
+  if (m_file)
+    std::setvbuf(m_file, &m_buffer[0], _IOFBF, m_buffer.size());
+}
+
+OutputSink::~OutputSink()
+{
+  if (m_writer) {
+    {
+      boost::lock_guard<boost::mutex> lock(m_mutex);
+      m_stop = true;
+    }
+    m_wake.notify_one();
+    m_writer->join();
+  }
+  if (m_file)
+    std::fclose(m_file);
+}
+
+void OutputSink::write(std::string* block)
+{
+  if (!m_writer) {
+    if (m_file) {
+      std::fwrite(block->data(), 1, block->size(), m_file);
+      if (m_flush)
+        std::fflush(m_file);
+    }
+    block->clear();
+    return;
+  }
+
+  {
+    boost::lock_guard<boost::mutex> lock(m_mutex);
+    m_queue.push_back(std::string());
+    m_queue.back().swap(*block);
+    if (!m_free.empty()) {
+      block->swap(m_free.back());
+      m_free.pop_back();
+    }
+  }
+  m_wake.notify_one();
+}
+
+void OutputSink::writerLoop()
+{
+  std::string block;
+  boost::unique_lock<boost::mutex> lock(m_mutex);
+  for (;;) {
+    while (!m_stop && m_queue.empty())
+      m_wake.wait(lock);
+    if (m_queue.empty())
+      return;
+    block.swap(m_queue.front());
+    m_queue.pop_front();
+
+    lock.unlock();
+    if (m_file)
+      std::fwrite(block.data(), 1, block.size(), m_file);
+    block.clear();
+    lock.lock();
+
+    // hand the buffer back for reuse
+    m_free.push_back(std::string());
+    m_free.back().swap(block);
+  }
+}
@@ -0,0 +1,78 @@
+// -----------------------------------------------------------
+//  File: sink.h
+//  Author: Gregory Rehbein
+//
+//  OutputSink class declaration. The single, long-lived writer
+//  of the output file. Each field's covering is rendered into
+//  one contiguous block and handed to the sink whole; the sink
+//  either writes it at once through a large stdio buffer, or,
+//  when asynchronous, queues it for a writer thread so that
+//  output stays off the optimizer's critical path. The buffers
+//  of written blocks are recycled back to the caller.
+//
+//  A streaming sink writes to a descriptor, such as stdout or
+//  a socket, and flushes each block as it is written, so that
+//  the reader sees every covering as soon as it is done.
+//
+//  Copyright (C) 2012 Gregory Rehbein <gmrehbein@gmail.com>
+// -----------------------------------------------------------
+
+#ifndef SINK_H
+#define SINK_H
+
+#include <cstdio>
+#include <deque>
+#include <string>
+#include <vector>
+#include <boost/scoped_ptr.hpp>
+#include <boost/thread/condition_variable.hpp>
+#include <boost/thread/mutex.hpp>
+#include <boost/thread/thread.hpp>
+#include <boost/utility.hpp>
+
+class OutputSink : boost::noncopyable
+{
+public:
+  //--------------------------------
+  // Opens path for appending, as the
+  // output file has always been
+  //--------------------------------
+  OutputSink(const std::string& path, bool async);
+
+  //--------------------------------
+  // Streaming sink: takes ownership of
+  // the descriptor and flushes every
+  // block
+  //--------------------------------
+  explicit OutputSink(int fd);
+
+  //--------------------------------
+  // Writes every queued block and
+  // closes the file
+  //--------------------------------
+  ~OutputSink();
+
+  //--------------------------------
+  // Takes the contents of *block for
+  // writing and leaves *block empty,
+  // with the capacity of a recycled
+  // buffer
+  //--------------------------------
+  void write(std::string* block);
+
+private:
+  void writerLoop();
+
+  std::FILE* m_file;
+  std::vector<char> m_buffer;  // stdio buffer of m_file
+  bool m_flush;                // after every block
+
+  boost::scoped_ptr<boost::thread> m_writer;
+  boost::mutex m_mutex;
+  boost::condition_variable m_wake;
+  std::deque<std::string> m_queue;
+  std::vector<std::string> m_free;
+  bool m_stop;
+};
+
+#endif // SINK_H
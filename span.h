@@ -0,0 +1,378 @@
+// -----------------------------------------------------------
+//  File: span.h
+//  Author: Gregory Rehbein
+//
+//  FieldSpan class template. A FieldSpan is a fixed-capacity
+//  bitmap over the cells of a strawberry field of at most
+//  MaxRows X MaxColumns cells, stored row-major: cell (i, j)
+//  of a field with n columns is bit i*n + j.
+//
+//  The words are stored inline and padded to a whole number
+//  of 64-byte cache lines, so a span never touches the heap.
+//  The set operations used in the inner loops of the optimizer
+//  (intersects, is_subset_of, difference) have AVX2 and NEON
+//  kernels, with a portable scalar fallback.
+//
+//  Copyright (C) 2012 Gregory Rehbein <gmrehbein@gmail.com>
+// -----------------------------------------------------------
+
+#ifndef SPAN_H
+#define SPAN_H
+
+#include <stdint.h>
+#include <cstddef>
+#include <cassert>
+#include <boost/config.hpp>
+
+#if defined(__AVX2__)
+#include <immintrin.h>
+#elif defined(__ARM_NEON)
+#include <arm_neon.h>
+#endif
+
+template <size_t MaxRows, size_t MaxColumns>
+class BOOST_ALIGNMENT(64) FieldSpan
+{
+public:
+  typedef uint64_t block_type;
+
+  static const size_t npos = static_cast<size_t>(-1);
+  static const size_t kBitsPerBlock = 64;
+  static const size_t kCapacity = MaxRows * MaxColumns;
+  // pad to a whole number of cache lines (8 blocks)
+  static const size_t kNumBlocks = ((kCapacity + 511) / 512) * 8;
+
+  FieldSpan() {
+    reset();
+  }
+
+  inline void reset() {
+    for (size_t i = 0; i < kNumBlocks; ++i)
+      m_blocks[i] = 0;
+  }
+
+  inline void set(size_t pos) {
+    assert(pos < kCapacity);
+    m_blocks[pos / kBitsPerBlock] |= block_type(1) << (pos % kBitsPerBlock);
+  }
+
+  //-----------------------------------
+  // Sets the len bits in [pos, pos + len)
+  //-----------------------------------
+  void set(size_t pos, size_t len) {
+    assert(pos + len <= kCapacity);
+    while (len > 0) {
+      size_t offset = pos % kBitsPerBlock;
+      size_t n = kBitsPerBlock - offset;
+      if (n > len)
+        n = len;
+      block_type mask = (n == kBitsPerBlock) ? ~block_type(0)
+                        : ((block_type(1) << n) - 1) << offset;
+      m_blocks[pos / kBitsPerBlock] |= mask;
+      pos += n;
+      len -= n;
+    }
+  }
+
+  inline bool test(size_t pos) const {
+    return (m_blocks[pos / kBitsPerBlock] >> (pos % kBitsPerBlock)) & 1;
+  }
+
+  bool any() const;
+  inline bool none() const {
+    return !any();
+  }
+
+  bool intersects(const FieldSpan& other) const;
+  bool is_subset_of(const FieldSpan& other) const;
+
+  FieldSpan& operator|=(const FieldSpan& other);
+  FieldSpan& operator&=(const FieldSpan& other);
+  FieldSpan& operator-=(const FieldSpan& other);
+
+  bool operator==(const FieldSpan& other) const;
+  inline bool operator!=(const FieldSpan& other) const {
+    return !(*this == other);
+  }
+
+  size_t find_first() const {
+    return find_from(0);
+  }
+  size_t find_next(size_t pos) const {
+    return ++pos < kCapacity ? find_from(pos) : npos;
+  }
+
+private:
+  size_t find_from(size_t pos) const;
+
+  block_type m_blocks[kNumBlocks];
+};
+
+template <size_t R, size_t C> const size_t FieldSpan<R, C>::npos;
+template <size_t R, size_t C> const size_t FieldSpan<R, C>::kBitsPerBlock;
+template <size_t R, size_t C> const size_t FieldSpan<R, C>::kCapacity;
+template <size_t R, size_t C> const size_t FieldSpan<R, C>::kNumBlocks;
+
+template <size_t R, size_t C>
+inline FieldSpan<R, C> operator|(const FieldSpan<R, C>& a, const FieldSpan<R, C>& b)
+{
+  FieldSpan<R, C> result(a);
+  return result |= b;
+}
+
+template <size_t R, size_t C>
+inline FieldSpan<R, C> operator&(const FieldSpan<R, C>& a, const FieldSpan<R, C>& b)
+{
+  FieldSpan<R, C> result(a);
+  return result &= b;
+}
+
+template <size_t R, size_t C>
+inline FieldSpan<R, C> operator-(const FieldSpan<R, C>& a, const FieldSpan<R, C>& b)
+{
+  FieldSpan<R, C> result(a);
+  return result -= b;
+}
+
+//----------------------------------------------
+// Kernels. Blocks are 64-byte aligned and the
+// block count is a multiple of 8, so the vector
+// loops need no remainder handling.
+//----------------------------------------------
+#if defined(__AVX2__)
+
+template <size_t R, size_t C>
+bool FieldSpan<R, C>::any() const
+{
+  __m256i acc = _mm256_setzero_si256();
+  for (size_t i = 0; i < kNumBlocks; i += 4)
+    acc = _mm256_or_si256(acc, _mm256_load_si256(reinterpret_cast<const __m256i*>(m_blocks + i)));
+  return !_mm256_testz_si256(acc, acc);
+}
+
+template <size_t R, size_t C>
+bool FieldSpan<R, C>::intersects(const FieldSpan& other) const
+{
+  for (size_t i = 0; i < kNumBlocks; i += 4) {
+    __m256i a = _mm256_load_si256(reinterpret_cast<const __m256i*>(m_blocks + i));
+    __m256i b = _mm256_load_si256(reinterpret_cast<const __m256i*>(other.m_blocks + i));
+    if (!_mm256_testz_si256(a, b))
+      return true;
+  }
+  return false;
+}
+
+template <size_t R, size_t C>
+bool FieldSpan<R, C>::is_subset_of(const FieldSpan& other) const
+{
+  for (size_t i = 0; i < kNumBlocks; i += 4) {
+    __m256i a = _mm256_load_si256(reinterpret_cast<const __m256i*>(m_blocks + i));
+    __m256i b = _mm256_load_si256(reinterpret_cast<const __m256i*>(other.m_blocks + i));
+    // testc: (~b & a) == 0
+    if (!_mm256_testc_si256(b, a))
+      return false;
+  }
+  return true;
+}
+
+template <size_t R, size_t C>
+FieldSpan<R, C>& FieldSpan<R, C>::operator|=(const FieldSpan& other)
+{
+  for (size_t i = 0; i < kNumBlocks; i += 4) {
+    __m256i* a = reinterpret_cast<__m256i*>(m_blocks + i);
+    __m256i b = _mm256_load_si256(reinterpret_cast<const __m256i*>(other.m_blocks + i));
+    _mm256_store_si256(a, _mm256_or_si256(_mm256_load_si256(a), b));
+  }
+  return *this;
+}
+
+template <size_t R, size_t C>
+FieldSpan<R, C>& FieldSpan<R, C>::operator&=(const FieldSpan& other)
+{
+  for (size_t i = 0; i < kNumBlocks; i += 4) {
+    __m256i* a = reinterpret_cast<__m256i*>(m_blocks + i);
+    __m256i b = _mm256_load_si256(reinterpret_cast<const __m256i*>(other.m_blocks + i));
+    _mm256_store_si256(a, _mm256_and_si256(_mm256_load_si256(a), b));
+  }
+  return *this;
+}
+
+template <size_t R, size_t C>
+FieldSpan<R, C>& FieldSpan<R, C>::operator-=(const FieldSpan& other)
+{
+  for (size_t i = 0; i < kNumBlocks; i += 4) {
+    __m256i* a = reinterpret_cast<__m256i*>(m_blocks + i);
+    __m256i b = _mm256_load_si256(reinterpret_cast<const __m256i*>(other.m_blocks + i));
+    // andnot computes ~b & a
+    _mm256_store_si256(a, _mm256_andnot_si256(b, _mm256_load_si256(a)));
+  }
+  return *this;
+}
+
+template <size_t R, size_t C>
+bool FieldSpan<R, C>::operator==(const FieldSpan& other) const
+{
+  for (size_t i = 0; i < kNumBlocks; i += 4) {
+    __m256i a = _mm256_load_si256(reinterpret_cast<const __m256i*>(m_blocks + i));
+    __m256i b = _mm256_load_si256(reinterpret_cast<const __m256i*>(other.m_blocks + i));
+    __m256i x = _mm256_xor_si256(a, b);
+    if (!_mm256_testz_si256(x, x))
+      return false;
+  }
+  return true;
+}
+
+#elif defined(__ARM_NEON)
+
+template <size_t R, size_t C>
+bool FieldSpan<R, C>::any() const
+{
+  uint64x2_t acc = vdupq_n_u64(0);
+  for (size_t i = 0; i < kNumBlocks; i += 2)
+    acc = vorrq_u64(acc, vld1q_u64(m_blocks + i));
+  return (vgetq_lane_u64(acc, 0) | vgetq_lane_u64(acc, 1)) != 0;
+}
+
+template <size_t R, size_t C>
+bool FieldSpan<R, C>::intersects(const FieldSpan& other) const
+{
+  for (size_t i = 0; i < kNumBlocks; i += 2) {
+    uint64x2_t x = vandq_u64(vld1q_u64(m_blocks + i), vld1q_u64(other.m_blocks + i));
+    if (vgetq_lane_u64(x, 0) | vgetq_lane_u64(x, 1))
+      return true;
+  }
+  return false;
+}
+
+template <size_t R, size_t C>
+bool FieldSpan<R, C>::is_subset_of(const FieldSpan& other) const
+{
+  for (size_t i = 0; i < kNumBlocks; i += 2) {
+    // vbicq computes a & ~b
+    uint64x2_t x = vbicq_u64(vld1q_u64(m_blocks + i), vld1q_u64(other.m_blocks + i));
+    if (vgetq_lane_u64(x, 0) | vgetq_lane_u64(x, 1))
+      return false;
+  }
+  return true;
+}
+
+template <size_t R, size_t C>
+FieldSpan<R, C>& FieldSpan<R, C>::operator|=(const FieldSpan& other)
+{
+  for (size_t i = 0; i < kNumBlocks; i += 2)
+    vst1q_u64(m_blocks + i, vorrq_u64(vld1q_u64(m_blocks + i), vld1q_u64(other.m_blocks + i)));
+  return *this;
+}
+
+template <size_t R, size_t C>
+FieldSpan<R, C>& FieldSpan<R, C>::operator&=(const FieldSpan& other)
+{
+  for (size_t i = 0; i < kNumBlocks; i += 2)
+    vst1q_u64(m_blocks + i, vandq_u64(vld1q_u64(m_blocks + i), vld1q_u64(other.m_blocks + i)));
+  return *this;
+}
+
+template <size_t R, size_t C>
+FieldSpan<R, C>& FieldSpan<R, C>::operator-=(const FieldSpan& other)
+{
+  for (size_t i = 0; i < kNumBlocks; i += 2)
+    vst1q_u64(m_blocks + i, vbicq_u64(vld1q_u64(m_blocks + i), vld1q_u64(other.m_blocks + i)));
+  return *this;
+}
+
+template <size_t R, size_t C>
+bool FieldSpan<R, C>::operator==(const FieldSpan& other) const
+{
+  for (size_t i = 0; i < kNumBlocks; i += 2) {
+    uint64x2_t x = veorq_u64(vld1q_u64(m_blocks + i), vld1q_u64(other.m_blocks + i));
+    if (vgetq_lane_u64(x, 0) | vgetq_lane_u64(x, 1))
+      return false;
+  }
+  return true;
+}
+
+#else
+
+template <size_t R, size_t C>
+bool FieldSpan<R, C>::any() const
+{
+  block_type acc = 0;
+  for (size_t i = 0; i < kNumBlocks; ++i)
+    acc |= m_blocks[i];
+  return acc != 0;
+}
+
+template <size_t R, size_t C>
+bool FieldSpan<R, C>::intersects(const FieldSpan& other) const
+{
+  for (size_t i = 0; i < kNumBlocks; ++i)
+    if (m_blocks[i] & other.m_blocks[i])
+      return true;
+  return false;
+}
+
+template <size_t R, size_t C>
+bool FieldSpan<R, C>::is_subset_of(const FieldSpan& other) const
+{
+  for (size_t i = 0; i < kNumBlocks; ++i)
+    if (m_blocks[i] & ~other.m_blocks[i])
+      return false;
+  return true;
+}
+
+template <size_t R, size_t C>
+FieldSpan<R, C>& FieldSpan<R, C>::operator|=(const FieldSpan& other)
+{
+  for (size_t i = 0; i < kNumBlocks; ++i)
+    m_blocks[i] |= other.m_blocks[i];
+  return *this;
+}
+
+template <size_t R, size_t C>
+FieldSpan<R, C>& FieldSpan<R, C>::operator&=(const FieldSpan& other)
+{
+  for (size_t i = 0; i < kNumBlocks; ++i)
+    m_blocks[i] &= other.m_blocks[i];
+  return *this;
+}
+
+template <size_t R, size_t C>
+FieldSpan<R, C>& FieldSpan<R, C>::operator-=(const FieldSpan& other)
+{
+  for (size_t i = 0; i < kNumBlocks; ++i)
+    m_blocks[i] &= ~other.m_blocks[i];
+  return *this;
+}
+
+template <size_t R, size_t C>
+bool FieldSpan<R, C>::operator==(const FieldSpan& other) const
+{
+  for (size_t i = 0; i < kNumBlocks; ++i)
+    if (m_blocks[i] != other.m_blocks[i])
+      return false;
+  return true;
+}
+
+#endif
+
+template <size_t R, size_t C>
+size_t FieldSpan<R, C>::find_from(size_t pos) const
+{
+  size_t i = pos / kBitsPerBlock;
+  block_type block = m_blocks[i] & (~block_type(0) << (pos % kBitsPerBlock));
+  while (block == 0) {
+    if (++i == kNumBlocks)
+      return npos;
+    block = m_blocks[i];
+  }
+  return i * kBitsPerBlock + __builtin_ctzll(block);
+}
+
+//--------------------------------------------------
+// The problem statement bounds fields at 50 X 50;
+// debug builds (CHECK_SPANS) cross-check the fields
+// that fit and skip larger ones
+//--------------------------------------------------
+typedef FieldSpan<50, 50> Span;
+
+#endif // SPAN_H
@@ -0,0 +1,99 @@
+// -----------------------------------------------------------
+//  File: statistics.cc
+//  Author: Gregory Rehbein
+//
+//  Copyright (C) 2012 Gregory Rehbein <gmrehbein@gmail.com>
+// -----------------------------------------------------------
+
+// Self
+#include "statistics.h"
+
+// C
+#include <cstdio>
+
+#include "timer.h"
+
+namespace
+{
+const char* phaseNames[] = {
+  "total", "generate", "greedy", "localSearch", "hull"
+};
+}  // end anon namespace
+
+Statistics::Statistics()
+{
+  clear();
+}
+
+void Statistics::clear()
+{
+  for (int p = 0; p < kNumPhases; ++p)
+    wallTime[p] = cpuTime[p] = 0;
+  rectanglesGenerated = rectanglesRejected = shadesEvaluated = moves = arenaBytes = 0;
+  active = NULL;
+}
+
+Statistics& Statistics::operator+=(const Statistics& other)
+{
+  for (int p = 0; p < kNumPhases; ++p) {
+    wallTime[p] += other.wallTime[p];
+    cpuTime[p] += other.cpuTime[p];
+  }
+  rectanglesGenerated += other.rectanglesGenerated;
+  rectanglesRejected += other.rectanglesRejected;
+  shadesEvaluated += other.shadesEvaluated;
+  moves += other.moves;
+  arenaBytes += other.arenaBytes;
+  return *this;
+}
+
+void Statistics::write(std::ostream& out) const
+{
+  char buffer[64];
+  out << "{\"phases\":{";
+  for (int p = 0; p < kNumPhases; ++p) {
+    snprintf(buffer, sizeof(buffer), "{\"wall\":%.6f,\"cpu\":%.6f}", wallTime[p], cpuTime[p]);
+    out << (p ? "," : "") << "\"" << phaseNames[p] << "\":" << buffer;
+  }
+  out << "},\"counters\":{"
+      << "\"rectanglesGenerated\":" << rectanglesGenerated
+      << ",\"rectanglesRejected\":" << rectanglesRejected
+      << ",\"shadesEvaluated\":" << shadesEvaluated
+      << ",\"moves\":" << moves
+      << ",\"arenaBytes\":" << arenaBytes
+      << "}}";
+}
+
+PhaseTimer::PhaseTimer(Statistics* statistics, Statistics::Phase phase)
+  : m_statistics(statistics), m_phase(phase), m_outer(NULL), m_wallStart(0), m_cpuStart(0)
+{
+  if (!m_statistics)
+    return;
+  m_outer = m_statistics->active;
+  if (m_outer)
+    m_outer->pause();
+  m_statistics->active = this;
+  resume();
+}
+
+PhaseTimer::~PhaseTimer()
+{
+  if (!m_statistics)
+    return;
+  pause();
+  m_statistics->active = m_outer;
+  if (m_outer)
+    m_outer->resume();
+}
+
+void PhaseTimer::pause()
+{
+  m_statistics->wallTime[m_phase] += ::wallTime() - m_wallStart;
+  m_statistics->cpuTime[m_phase] += ::cpuTime() - m_cpuStart;
+}
+
+void PhaseTimer::resume()
+{
+  m_wallStart = ::wallTime();
+  m_cpuStart = ::cpuTime();
+}
@@ -0,0 +1,91 @@
+// -----------------------------------------------------------
+//  File: statistics.h
+//  Author: Gregory Rehbein
+//
+//  Statistics and PhaseTimer declarations. Instrumentation
+//  of an optimizer run: wall-clock and CPU time spent in each
+//  phase of the pipeline, and counters of the work done. The
+//  counters are always kept; the clocks are only read while
+//  statistics are enabled, so a disabled run pays for a few
+//  increments and nothing else.
+//
+//  Copyright (C) 2012 Gregory Rehbein <gmrehbein@gmail.com>
+// -----------------------------------------------------------
+
+#ifndef STATISTICS_H
+#define STATISTICS_H
+
+#include <cstddef>
+#include <ostream>
+#include <boost/utility.hpp>
+
+class PhaseTimer;
+
+struct Statistics {
+  //--------------------------------
+  // kTotal spans a whole run; the
+  // other phases are exclusive, so
+  // window regeneration during the
+  // greedy phase counts as kGenerate
+  //--------------------------------
+  enum Phase {
+    kTotal = 0,
+    kGenerate,
+    kGreedy,
+    kLocalSearch,
+    kHull,
+    kNumPhases
+  };
+
+  double wallTime[kNumPhases];
+  double cpuTime[kNumPhases];
+
+  size_t rectanglesGenerated;  // candidates emitted by generateRectangles()
+  size_t rectanglesRejected;   // candidates findNextRectangle() found covered
+  size_t shadesEvaluated;
+  size_t moves;                // joins applied by localSearch()
+  size_t arenaBytes;           // allocated from the rectangle arenas
+
+  PhaseTimer* active;
+
+  Statistics();
+  void clear();
+
+  //--------------------------------
+  // Adds the times and counters of
+  // another run
+  //--------------------------------
+  Statistics& operator+=(const Statistics& other);
+
+  //--------------------------------
+  // Writes the statistics as a JSON
+  // object
+  //--------------------------------
+  void write(std::ostream& out) const;
+};
+
+//--------------------------------------
+// Charges the time of its scope to a
+// phase, pausing the phase of the
+// enclosing PhaseTimer meanwhile. A NULL
+// Statistics disables the timer.
+// CPU time is that of the calling thread.
+//--------------------------------------
+class PhaseTimer : boost::noncopyable
+{
+public:
+  PhaseTimer(Statistics* statistics, Statistics::Phase phase);
+  ~PhaseTimer();
+
+private:
+  void pause();
+  void resume();
+
+  Statistics* m_statistics;
+  Statistics::Phase m_phase;
+  PhaseTimer* m_outer;
+  double m_wallStart;
+  double m_cpuStart;
+};
+
+#endif // STATISTICS_H
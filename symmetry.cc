@@ -0,0 +1,108 @@
+// -----------------------------------------------------------
+//  File: symmetry.cc
+//  Author: Gregory Rehbein
+//
+//  Copyright (C) 2012 Gregory Rehbein <gmrehbein@gmail.com>
+// -----------------------------------------------------------
+
+// Self
+#include "symmetry.h"
+
+// C++
+#include <algorithm>
+#include <vector>
+
+#include "covering.h"
+#include "field.h"
+
+using std::min;
+using std::max;
+using std::swap;
+using std::vector;
+
+Symmetry inverse(Symmetry g)
+{
+  if (g == kRotate90)
+    return kRotate270;
+  if (g == kRotate270)
+    return kRotate90;
+  return g;
+}
+
+void transformCell(Symmetry g, size_t numRows, size_t numColumns,
+                   int* row, int* column)
+{
+  const int M = numRows;
+  const int N = numColumns;
+  const int i = *row;
+  const int j = *column;
+  switch (g) {
+  case kIdentity:
+    break;
+  case kRotate90:
+    *row = j;
+    *column = M - 1 - i;
+    break;
+  case kRotate180:
+    *row = M - 1 - i;
+    *column = N - 1 - j;
+    break;
+  case kRotate270:
+    *row = N - 1 - j;
+    *column = i;
+    break;
+  case kFlipRows:
+    *row = M - 1 - i;
+    break;
+  case kFlipColumns:
+    *column = N - 1 - j;
+    break;
+  case kTranspose:
+    *row = j;
+    *column = i;
+    break;
+  case kAntiTranspose:
+    *row = N - 1 - j;
+    *column = M - 1 - i;
+    break;
+  default:
+    break;
+  }
+}
+
+Box transformBox(Symmetry g, size_t numRows, size_t numColumns, const Box& box)
+{
+  int r1 = box.topLeftRow;
+  int c1 = box.topLeftColumn;
+  int r2 = box.bottomRightRow;
+  int c2 = box.bottomRightColumn;
+  transformCell(g, numRows, numColumns, &r1, &c1);
+  transformCell(g, numRows, numColumns, &r2, &c2);
+  Box image = { min(r1, r2), min(c1, c2), max(r1, r2), max(c1, c2) };
+  return image;
+}
+
+void transformField(Symmetry g, const Field& field, Field* image)
+{
+  const size_t M = field.numRows();
+  const size_t N = field.numColumns();
+  size_t rows = M;
+  size_t columns = N;
+  if (swapsAxes(g))
+    swap(rows, columns);
+
+  vector<vector<int> > cells(rows, vector<int>(columns, 0));
+  for (size_t i = 0; i < M; ++i) {
+    for (size_t j = 0; j < N; ++j) {
+      int row = i;
+      int column = j;
+      transformCell(g, M, N, &row, &column);
+      cells[row][column] = field.at(i, j);
+    }
+  }
+
+  image->clear();
+  for (size_t i = 0; i < rows; ++i)
+    image->addRow(cells[i]);
+  image->index();
+}
@@ -0,0 +1,61 @@
+// -----------------------------------------------------------
+//  File: symmetry.h
+//  Author: Gregory Rehbein
+//
+//  The dihedral group D4 acting on an M X N strawberry field:
+//  the identity, three rotations, and four reflections. Used
+//  by the Portfolio to run the optimizer on every symmetric
+//  image of a field and map the best covering back.
+//
+//  Copyright (C) 2012 Gregory Rehbein <gmrehbein@gmail.com>
+// -----------------------------------------------------------
+
+#ifndef SYMMETRY_H
+#define SYMMETRY_H
+
+#include <cstddef>
+
+class Field;
+struct Box;
+
+enum Symmetry {
+  kIdentity = 0,
+  kRotate90,       // clockwise
+  kRotate180,
+  kRotate270,
+  kFlipRows,       // top <-> bottom
+  kFlipColumns,    // left <-> right
+  kTranspose,      // about the main diagonal
+  kAntiTranspose,  // about the anti-diagonal
+  kNumSymmetries
+};
+
+Symmetry inverse(Symmetry g);
+
+//--------------------------------------------
+// true if g exchanges rows and columns
+//--------------------------------------------
+inline bool swapsAxes(Symmetry g)
+{
+  return g == kRotate90 || g == kRotate270 || g == kTranspose || g == kAntiTranspose;
+}
+
+//--------------------------------------------
+// Image of cell (row, column) of an
+// numRows X numColumns field under g
+//--------------------------------------------
+void transformCell(Symmetry g, size_t numRows, size_t numColumns,
+                   int* row, int* column);
+
+//--------------------------------------------
+// Image of a rectangle of an numRows X
+// numColumns field under g
+//--------------------------------------------
+Box transformBox(Symmetry g, size_t numRows, size_t numColumns, const Box& box);
+
+//--------------------------------------------
+// Indexed image of a field under g
+//--------------------------------------------
+void transformField(Symmetry g, const Field& field, Field* image);
+
+#endif // SYMMETRY_H
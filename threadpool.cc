@@ -0,0 +1,95 @@
+// -----------------------------------------------------------
+//  File: threadpool.cc
+//  Author: Gregory Rehbein
+//
+//  Copyright (C) 2012 Gregory Rehbein <gmrehbein@gmail.com>
+// -----------------------------------------------------------
+
+// Self
+#include "threadpool.h"
+
+// C
+#include <cassert>
+
+// Boost
+#include <boost/bind/bind.hpp>
+
+ThreadPool::ThreadPool(size_t numWorkers)
+  : m_numWorkers(numWorkers ? numWorkers : 1), m_task(NULL),
+    m_count(0), m_next(0), m_generation(0), m_busy(0), m_stop(false)
+{
+  for (size_t worker = 1; worker < m_numWorkers; ++worker)
+    m_threads.create_thread(boost::bind(&ThreadPool::workerLoop, this, worker));
+}
+
+ThreadPool::~ThreadPool()
+{
+  {
+    boost::lock_guard<boost::mutex> lock(m_mutex);
+    m_stop = true;
+  }
+  m_wake.notify_all();
+  m_threads.join_all();
+}
+
+void ThreadPool::parallelFor(size_t count, const Task& task)
+{
+  if (m_numWorkers == 1 || count < 2) {
+    for (size_t i = 0; i < count; ++i)
+      task(i, 0);
+    return;
+  }
+
+  {
+    boost::lock_guard<boost::mutex> lock(m_mutex);
+    assert(m_task == NULL);
+    m_task = &task;
+    m_count = count;
+    m_next = 0;
+    m_busy = m_numWorkers - 1;
+    ++m_generation;
+  }
+  m_wake.notify_all();
+
+  drain(0);
+
+  boost::unique_lock<boost::mutex> lock(m_mutex);
+  while (m_busy > 0)
+    m_done.wait(lock);
+  m_task = NULL;
+}
+
+void ThreadPool::workerLoop(size_t worker)
+{
+  size_t generation = 0;
+  for (;;) {
+    {
+      boost::unique_lock<boost::mutex> lock(m_mutex);
+      while (!m_stop && generation == m_generation)
+        m_wake.wait(lock);
+      if (m_stop)
+        return;
+      generation = m_generation;
+    }
+    drain(worker);
+    {
+      boost::lock_guard<boost::mutex> lock(m_mutex);
+      if (--m_busy == 0)
+        m_done.notify_one();
+    }
+  }
+}
+
+//--------------------------------
+// Claims loop indices one at a time
+// until none are left
+//--------------------------------
+void ThreadPool::drain(size_t worker)
+{
+  for (;;) {
+    size_t i = m_next.fetch_add(1);
+    if (i >= m_count)
+      return;
+    (*m_task)(i, worker);
+  }
+}
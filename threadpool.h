@@ -0,0 +1,65 @@
+// -----------------------------------------------------------
+//  File: threadpool.h
+//  Author: Gregory Rehbein
+//
+//  ThreadPool class declaration. A fixed set of worker
+//  threads that execute the iterations of a parallel loop.
+//  The calling thread takes part as worker 0, so a pool of
+//  size 1 runs every loop inline without any threads.
+//
+//  Copyright (C) 2012 Gregory Rehbein <gmrehbein@gmail.com>
+// -----------------------------------------------------------
+
+#ifndef THREADPOOL_H
+#define THREADPOOL_H
+
+#include <cstddef>
+#include <boost/atomic.hpp>
+#include <boost/function.hpp>
+#include <boost/thread/condition_variable.hpp>
+#include <boost/thread/mutex.hpp>
+#include <boost/thread/thread.hpp>
+#include <boost/utility.hpp>
+
+class ThreadPool : boost::noncopyable
+{
+public:
+  //--------------------------------
+  // (index, worker) -> void, where
+  // worker is in [0, size())
+  //--------------------------------
+  typedef boost::function<void (size_t, size_t)> Task;
+
+  explicit ThreadPool(size_t numWorkers);
+  ~ThreadPool();
+
+  inline size_t size() const {
+    return m_numWorkers;
+  }
+
+  //--------------------------------
+  // Calls task(i, worker) for every i in
+  // [0, count) and returns when all calls
+  // have completed. Not re-entrant.
+  //--------------------------------
+  void parallelFor(size_t count, const Task& task);
+
+private:
+  void workerLoop(size_t worker);
+  void drain(size_t worker);
+
+  const size_t m_numWorkers;
+  boost::thread_group m_threads;
+  boost::mutex m_mutex;
+  boost::condition_variable m_wake;
+  boost::condition_variable m_done;
+
+  const Task* m_task;
+  size_t m_count;
+  boost::atomic<size_t> m_next;
+  size_t m_generation;
+  size_t m_busy;
+  bool m_stop;
+};
+
+#endif // THREADPOOL_H
@@ -0,0 +1,37 @@
+// -----------------------------------------------------------
+//  File: timer.h
+//  Author: Gregory Rehbein
+//
+//  Wall-clock and CPU time sources used for deadlines and
+//  timing of optimizer runs.
+//
+//  Copyright (C) 2012 Gregory Rehbein <gmrehbein@gmail.com>
+// -----------------------------------------------------------
+
+#ifndef TIMER_H
+#define TIMER_H
+
+#include <time.h>
+
+//-----------------------------------
+// Seconds on the monotonic clock
+//-----------------------------------
+inline double wallTime()
+{
+  timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return ts.tv_sec + ts.tv_nsec*1e-9;
+}
+
+//-----------------------------------
+// CPU seconds consumed by the calling
+// thread
+//-----------------------------------
+inline double cpuTime()
+{
+  timespec ts;
+  clock_gettime(CLOCK_THREAD_CPUTIME_ID, &ts);
+  return ts.tv_sec + ts.tv_nsec*1e-9;
+}
+
+#endif // TIMER_H